@@ -0,0 +1,595 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатия (contraction hierarchy) над DirectedWeightedGraph.
+// При построении вершины упорядочиваются по важности и по очереди "сжимаются",
+// а кратчайшие пути через сжатую вершину сохраняются в виде рёбер-сокращений.
+// Запрос - двунаправленный поиск только вверх по иерархии, после чего
+// сокращения разворачиваются обратно в рёбра исходного графа
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    // Сокращение заменяет путь из двух рёбер иерархии first_edge и second_edge.
+    // Рёбра иерархии с id меньше числа рёбер графа - это рёбра самого графа,
+    // остальные - сокращения в порядке их добавления
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first_edge;
+        EdgeId second_edge;
+    };
+
+    struct HierarchyData {
+        std::vector<size_t> ranks;
+        std::vector<Shortcut> shortcuts;
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+    // Принимает заранее построенную иерархию (например, загруженную из базы)
+    ContractionHierarchy(const Graph& graph, HierarchyData hierarchy_data);
+
+    // Не потокобезопасен: все запросы используют общее рабочее пространство
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Маршруты из одной вершины во все targets: поиск вверх от from выполняется один раз
+    // целиком, а для каждой цели запускается только обратный поиск
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+    // Веса маршрутов из каждой origins в каждую targets построчно, INFINITE_WEIGHT - маршрута нет.
+    // Обратный поиск из каждой цели раскладывает свои веса по корзинам вершин, затем прямой
+    // поиск из каждой origins просматривает корзины достигнутых вершин. Поиски одного
+    // направления идут параллельно, у каждого потока своё рабочее пространство
+    std::vector<Weight> BuildWeights(const std::vector<VertexId>& origins, const std::vector<VertexId>& targets) const;
+    const HierarchyData& GetHierarchyData() const;
+
+private:
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+    };
+
+    struct Workspace {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> epochs;
+        std::vector<std::pair<Weight, VertexId>> heap;
+        uint32_t epoch = 0;
+
+        explicit Workspace(size_t vertex_count)
+            : weights(vertex_count)
+            , prev_edges(vertex_count)
+            , epochs(vertex_count, 0) {
+        }
+
+        void StartSearch() {
+            heap.clear();
+            if (++epoch == 0) {
+                std::fill(epochs.begin(), epochs.end(), 0);
+                epoch = 1;
+            }
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return epochs[vertex] == epoch;
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            epochs[vertex] = epoch;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            heap.emplace_back(weight, vertex);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+
+        Weight TopWeight() const {
+            return heap.empty() ? INFINITE_WEIGHT : heap.front().first;
+        }
+
+        std::pair<Weight, VertexId> Pop() {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto top = heap.back();
+            heap.pop_back();
+            return top;
+        }
+    };
+
+    // Вершина соседа и лучшее ребро иерархии до него
+    using Neighbour = std::pair<VertexId, EdgeId>;
+
+    // Ограничение на число вершин, просматриваемых при поиске свидетеля.
+    // Если свидетель не найден за это число шагов, сокращение добавляется
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = Router<Weight>::INFINITE_WEIGHT;
+    static constexpr EdgeId NO_EDGE = Router<Weight>::NO_EDGE;
+
+    HierarchyEdge GetHierarchyEdge(EdgeId edge_id) const {
+        const size_t edge_count = graph_.GetEdgeCount();
+        if (edge_id < edge_count) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            return { edge.from, edge.to, edge.weight };
+        }
+        const Shortcut& shortcut = hierarchy_data_.shortcuts[edge_id - edge_count];
+        return { shortcut.from, shortcut.to, shortcut.weight };
+    }
+
+    // Оставляет для каждого соседа только самое лёгкое ребро до ещё не сжатых вершин
+    std::vector<Neighbour> CollectNeighbours(VertexId vertex, const std::vector<EdgeId>& edges,
+        const std::vector<bool>& contracted, bool outgoing) const {
+        std::vector<Neighbour> neighbours;
+        for (const EdgeId edge_id : edges) {
+            const HierarchyEdge edge = GetHierarchyEdge(edge_id);
+            const VertexId neighbour = outgoing ? edge.to : edge.from;
+            if (neighbour != vertex && !contracted[neighbour]) {
+                neighbours.emplace_back(neighbour, edge_id);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end(), [this](const Neighbour& lhs, const Neighbour& rhs) {
+            return lhs.first != rhs.first ? lhs.first < rhs.first
+                                          : GetHierarchyEdge(lhs.second).weight < GetHierarchyEdge(rhs.second).weight;
+        });
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end(), [](const Neighbour& lhs, const Neighbour& rhs) {
+            return lhs.first == rhs.first;
+        }), neighbours.end());
+        return neighbours;
+    }
+
+    // Поиск пути-свидетеля из source в обход вершины skipped среди несжатых вершин
+    void RunWitnessSearch(Workspace& ws, VertexId source, VertexId skipped, Weight max_weight,
+        const std::vector<std::vector<EdgeId>>& out_edges, const std::vector<bool>& contracted) const {
+        ws.StartSearch();
+        ws.Reach(source, ZERO_WEIGHT, NO_EDGE);
+        size_t settled_count = 0;
+        while (!ws.heap.empty() && settled_count < WITNESS_SETTLE_LIMIT) {
+            const auto [weight, vertex] = ws.Pop();
+            if (ws.weights[vertex] < weight) {
+                continue;
+            }
+            if (weight > max_weight) {
+                break;
+            }
+            ++settled_count;
+            for (const EdgeId edge_id : out_edges[vertex]) {
+                const HierarchyEdge edge = GetHierarchyEdge(edge_id);
+                if (edge.to == skipped || contracted[edge.to]) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + edge.weight;
+                if (!ws.IsReached(edge.to) || candidate_weight < ws.weights[edge.to]) {
+                    ws.Reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+    }
+
+    // Считает (и при apply == true добавляет) сокращения, нужные при сжатии вершины
+    size_t ContractVertex(Workspace& ws, VertexId vertex, bool apply,
+        std::vector<std::vector<EdgeId>>& out_edges, std::vector<std::vector<EdgeId>>& in_edges,
+        const std::vector<bool>& contracted, size_t& neighbour_count) {
+        const auto in_neighbours = CollectNeighbours(vertex, in_edges[vertex], contracted, false);
+        const auto out_neighbours = CollectNeighbours(vertex, out_edges[vertex], contracted, true);
+        neighbour_count = in_neighbours.size() + out_neighbours.size();
+
+        size_t shortcut_count = 0;
+        for (const auto& [from, in_edge_id] : in_neighbours) {
+            const Weight in_weight = GetHierarchyEdge(in_edge_id).weight;
+            Weight max_weight = ZERO_WEIGHT;
+            for (const auto& [to, out_edge_id] : out_neighbours) {
+                if (to != from) {
+                    max_weight = std::max(max_weight, in_weight + GetHierarchyEdge(out_edge_id).weight);
+                }
+            }
+            RunWitnessSearch(ws, from, vertex, max_weight, out_edges, contracted);
+
+            for (const auto& [to, out_edge_id] : out_neighbours) {
+                if (to == from) {
+                    continue;
+                }
+                const Weight shortcut_weight = in_weight + GetHierarchyEdge(out_edge_id).weight;
+                if (ws.IsReached(to) && ws.weights[to] <= shortcut_weight) {
+                    continue;
+                }
+                ++shortcut_count;
+                if (apply) {
+                    const EdgeId shortcut_id = graph_.GetEdgeCount() + hierarchy_data_.shortcuts.size();
+                    hierarchy_data_.shortcuts.push_back({ from, to, shortcut_weight, in_edge_id, out_edge_id });
+                    out_edges[from].push_back(shortcut_id);
+                    in_edges[to].push_back(shortcut_id);
+                }
+            }
+        }
+        return shortcut_count;
+    }
+
+    void BuildHierarchy() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<std::vector<EdgeId>> out_edges(vertex_count);
+        std::vector<std::vector<EdgeId>> in_edges(vertex_count);
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            out_edges[edge.from].push_back(edge_id);
+            in_edges[edge.to].push_back(edge_id);
+        }
+
+        std::vector<bool> contracted(vertex_count, false);
+        std::vector<size_t> contracted_neighbours(vertex_count, 0);
+        Workspace ws(vertex_count);
+        // Приоритет вершины: разность числа добавляемых сокращений и удаляемых рёбер
+        // плюс число уже сжатых соседей, чтобы сжатие шло равномерно по графу
+        const auto compute_priority = [&](VertexId vertex) {
+            size_t neighbour_count = 0;
+            const size_t shortcut_count = ContractVertex(ws, vertex, false, out_edges, in_edges, contracted, neighbour_count);
+            return static_cast<int64_t>(shortcut_count) - static_cast<int64_t>(neighbour_count)
+                + static_cast<int64_t>(contracted_neighbours[vertex]);
+        };
+
+        using QueueItem = std::pair<int64_t, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.emplace(compute_priority(vertex), vertex);
+        }
+
+        hierarchy_data_.ranks.assign(vertex_count, 0);
+        size_t rank = 0;
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (contracted[vertex]) {
+                continue;
+            }
+            // Ленивое обновление: приоритет пересчитывается перед сжатием,
+            // и если вершина перестала быть лучшей, она возвращается в очередь
+            const int64_t priority = compute_priority(vertex);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.emplace(priority, vertex);
+                continue;
+            }
+
+            size_t neighbour_count = 0;
+            ContractVertex(ws, vertex, true, out_edges, in_edges, contracted, neighbour_count);
+            contracted[vertex] = true;
+            hierarchy_data_.ranks[vertex] = rank++;
+            for (const EdgeId edge_id : out_edges[vertex]) {
+                ++contracted_neighbours[GetHierarchyEdge(edge_id).to];
+            }
+            for (const EdgeId edge_id : in_edges[vertex]) {
+                ++contracted_neighbours[GetHierarchyEdge(edge_id).from];
+            }
+        }
+    }
+
+    // Строит списки рёбер, ведущих вверх по иерархии: upward - из вершины,
+    // downward - в вершину из более важной (для обратного поиска)
+    void BuildSearchGraph() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t hierarchy_edge_count = graph_.GetEdgeCount() + hierarchy_data_.shortcuts.size();
+        const auto& ranks = hierarchy_data_.ranks;
+        upward_offsets_.assign(vertex_count + 1, 0);
+        downward_offsets_.assign(vertex_count + 1, 0);
+        for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id) {
+            const HierarchyEdge edge = GetHierarchyEdge(edge_id);
+            if (ranks[edge.from] < ranks[edge.to]) {
+                ++upward_offsets_[edge.from + 1];
+            }
+            else if (ranks[edge.from] > ranks[edge.to]) {
+                ++downward_offsets_[edge.to + 1];
+            }
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            upward_offsets_[vertex + 1] += upward_offsets_[vertex];
+            downward_offsets_[vertex + 1] += downward_offsets_[vertex];
+        }
+        upward_edges_.resize(upward_offsets_.back());
+        downward_edges_.resize(downward_offsets_.back());
+        std::vector<size_t> upward_positions(upward_offsets_.begin(), upward_offsets_.end() - 1);
+        std::vector<size_t> downward_positions(downward_offsets_.begin(), downward_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id) {
+            const HierarchyEdge edge = GetHierarchyEdge(edge_id);
+            if (ranks[edge.from] < ranks[edge.to]) {
+                upward_edges_[upward_positions[edge.from]++] = edge_id;
+            }
+            else if (ranks[edge.from] > ranks[edge.to]) {
+                downward_edges_[downward_positions[edge.to]++] = edge_id;
+            }
+        }
+    }
+
+    // Один шаг поиска вверх по иерархии. Возвращает false, если продолжать поиск не нужно
+    bool SearchStep(Workspace& ws, const Workspace& other_ws, bool forward, Weight& best_weight, VertexId& meeting_vertex) const {
+        if (ws.TopWeight() >= best_weight) {
+            ws.heap.clear();
+            return false;
+        }
+        const auto [weight, vertex] = ws.Pop();
+        if (ws.weights[vertex] < weight) {
+            return true;
+        }
+        if (other_ws.IsReached(vertex) && weight + other_ws.weights[vertex] < best_weight) {
+            best_weight = weight + other_ws.weights[vertex];
+            meeting_vertex = vertex;
+        }
+        const auto& offsets = forward ? upward_offsets_ : downward_offsets_;
+        const auto& edges = forward ? upward_edges_ : downward_edges_;
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const HierarchyEdge edge = GetHierarchyEdge(edges[i]);
+            const VertexId next = forward ? edge.to : edge.from;
+            const Weight candidate_weight = weight + edge.weight;
+            if (!ws.IsReached(next) || candidate_weight < ws.weights[next]) {
+                ws.Reach(next, candidate_weight, edges[i]);
+            }
+        }
+        return true;
+    }
+
+    // Поиск вверх по иерархии из source без ограничений. Вершины попадают в settled
+    // в порядке окончательного определения их весов
+    void RunUpwardSearch(Workspace& ws, VertexId source, bool forward, std::vector<VertexId>& settled) const {
+        settled.clear();
+        ws.StartSearch();
+        ws.Reach(source, ZERO_WEIGHT, NO_EDGE);
+        const auto& offsets = forward ? upward_offsets_ : downward_offsets_;
+        const auto& edges = forward ? upward_edges_ : downward_edges_;
+        while (!ws.heap.empty()) {
+            const auto [weight, vertex] = ws.Pop();
+            if (ws.weights[vertex] < weight) {
+                continue;
+            }
+            settled.push_back(vertex);
+            for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                const HierarchyEdge edge = GetHierarchyEdge(edges[i]);
+                const VertexId next = forward ? edge.to : edge.from;
+                const Weight candidate_weight = weight + edge.weight;
+                if (!ws.IsReached(next) || candidate_weight < ws.weights[next]) {
+                    ws.Reach(next, candidate_weight, edges[i]);
+                }
+            }
+        }
+    }
+
+    // Собирает маршрут из цепочек прямого и обратного поиска, сходящихся в meeting_vertex
+    RouteInfo BuildPath(const Workspace& forward_ws, const Workspace& backward_ws, VertexId meeting_vertex, Weight weight) const {
+        std::vector<EdgeId> hierarchy_edges;
+        for (EdgeId edge_id = forward_ws.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+            edge_id = forward_ws.prev_edges[GetHierarchyEdge(edge_id).from])
+        {
+            hierarchy_edges.push_back(edge_id);
+        }
+        std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+        for (EdgeId edge_id = backward_ws.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+            edge_id = backward_ws.prev_edges[GetHierarchyEdge(edge_id).to])
+        {
+            hierarchy_edges.push_back(edge_id);
+        }
+
+        std::vector<EdgeId> edges;
+        for (const EdgeId edge_id : hierarchy_edges) {
+            UnpackEdge(edge_id, edges);
+        }
+        return RouteInfo{ weight, std::move(edges) };
+    }
+
+    void CheckVertex(VertexId vertex) const {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    // Разворачивает ребро иерархии в последовательность рёбер исходного графа
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+        const size_t edge_count = graph_.GetEdgeCount();
+        std::vector<EdgeId> stack{ edge_id };
+        while (!stack.empty()) {
+            const EdgeId current = stack.back();
+            stack.pop_back();
+            if (current < edge_count) {
+                edges.push_back(current);
+                continue;
+            }
+            const Shortcut& shortcut = hierarchy_data_.shortcuts[current - edge_count];
+            stack.push_back(shortcut.second_edge);
+            stack.push_back(shortcut.first_edge);
+        }
+    }
+
+    const Graph& graph_;
+    HierarchyData hierarchy_data_;
+    std::vector<size_t> upward_offsets_;
+    std::vector<EdgeId> upward_edges_;
+    std::vector<size_t> downward_offsets_;
+    std::vector<EdgeId> downward_edges_;
+    mutable Workspace forward_workspace_;
+    mutable Workspace backward_workspace_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+    , forward_workspace_(graph.GetVertexCount())
+    , backward_workspace_(graph.GetVertexCount())
+{
+    BuildHierarchy();
+    BuildSearchGraph();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, HierarchyData hierarchy_data)
+    : graph_(graph)
+    , hierarchy_data_(std::move(hierarchy_data))
+    , forward_workspace_(graph.GetVertexCount())
+    , backward_workspace_(graph.GetVertexCount())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t hierarchy_edge_count = graph.GetEdgeCount() + hierarchy_data_.shortcuts.size();
+    if (hierarchy_data_.ranks.size() != vertex_count) {
+        throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+    }
+    for (const Shortcut& shortcut : hierarchy_data_.shortcuts) {
+        if (shortcut.from >= vertex_count || shortcut.to >= vertex_count
+            || shortcut.first_edge >= hierarchy_edge_count || shortcut.second_edge >= hierarchy_edge_count) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+    }
+    BuildSearchGraph();
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(VertexId from,
+    VertexId to) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    Workspace& forward_ws = forward_workspace_;
+    Workspace& backward_ws = backward_workspace_;
+    forward_ws.StartSearch();
+    backward_ws.StartSearch();
+    forward_ws.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    backward_ws.Reach(to, ZERO_WEIGHT, NO_EDGE);
+
+    Weight best_weight = INFINITE_WEIGHT;
+    VertexId meeting_vertex = from;
+    bool forward_active = true;
+    bool backward_active = true;
+    while (forward_active || backward_active) {
+        const bool forward_turn = forward_active
+            && (!backward_active || forward_ws.TopWeight() <= backward_ws.TopWeight());
+        if (forward_turn) {
+            forward_active = SearchStep(forward_ws, backward_ws, true, best_weight, meeting_vertex);
+        }
+        else {
+            backward_active = SearchStep(backward_ws, forward_ws, false, best_weight, meeting_vertex);
+        }
+    }
+    if (best_weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    return BuildPath(forward_ws, backward_ws, meeting_vertex, best_weight);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename ContractionHierarchy<Weight>::RouteInfo>> ContractionHierarchy<Weight>::BuildRoutes(VertexId from,
+    const std::vector<VertexId>& targets) const {
+    CheckVertex(from);
+    Workspace& forward_ws = forward_workspace_;
+    Workspace& backward_ws = backward_workspace_;
+    forward_ws.StartSearch();
+    forward_ws.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    // Полный поиск вверх: встречный поиск пуст, поэтому best_weight остаётся бесконечным
+    backward_ws.StartSearch();
+    Weight unbounded_weight = INFINITE_WEIGHT;
+    VertexId unused_vertex = from;
+    while (!forward_ws.heap.empty()) {
+        SearchStep(forward_ws, backward_ws, true, unbounded_weight, unused_vertex);
+    }
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        CheckVertex(to);
+        backward_ws.StartSearch();
+        backward_ws.Reach(to, ZERO_WEIGHT, NO_EDGE);
+        Weight best_weight = INFINITE_WEIGHT;
+        VertexId meeting_vertex = to;
+        while (SearchStep(backward_ws, forward_ws, false, best_weight, meeting_vertex)) {
+        }
+        if (best_weight == INFINITE_WEIGHT) {
+            routes.push_back(std::nullopt);
+        }
+        else {
+            routes.push_back(BuildPath(forward_ws, backward_ws, meeting_vertex, best_weight));
+        }
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::vector<Weight> ContractionHierarchy<Weight>::BuildWeights(const std::vector<VertexId>& origins,
+    const std::vector<VertexId>& targets) const {
+    for (const VertexId from : origins) {
+        CheckVertex(from);
+    }
+    for (const VertexId to : targets) {
+        CheckVertex(to);
+    }
+    const size_t vertex_count = graph_.GetVertexCount();
+    parallel::ThreadPool thread_pool;
+
+    // Вершины, до которых поднимается обратный поиск из каждой цели, с весами путей от них до цели
+    std::vector<std::vector<std::pair<VertexId, Weight>>> target_spaces(targets.size());
+    const size_t target_chunk_count = std::min(targets.size(), thread_pool.GetThreadCount());
+    thread_pool.ParallelFor(target_chunk_count, [&](size_t chunk) {
+        Workspace ws(vertex_count);
+        std::vector<VertexId> settled;
+        for (size_t column = chunk; column < targets.size(); column += target_chunk_count) {
+            RunUpwardSearch(ws, targets[column], false, settled);
+            target_spaces[column].reserve(settled.size());
+            for (const VertexId vertex : settled) {
+                target_spaces[column].emplace_back(vertex, ws.weights[vertex]);
+            }
+        }
+    });
+
+    // Корзины в формате CSR: для каждой вершины - номера целей и веса от вершины до них
+    std::vector<size_t> bucket_offsets(vertex_count + 1, 0);
+    for (const auto& space : target_spaces) {
+        for (const auto& [vertex, weight] : space) {
+            ++bucket_offsets[vertex + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        bucket_offsets[vertex + 1] += bucket_offsets[vertex];
+    }
+    std::vector<std::pair<size_t, Weight>> buckets(bucket_offsets.back());
+    std::vector<size_t> bucket_positions(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    for (size_t column = 0; column < targets.size(); ++column) {
+        for (const auto& [vertex, weight] : target_spaces[column]) {
+            buckets[bucket_positions[vertex]++] = { column, weight };
+        }
+    }
+
+    std::vector<Weight> weights(origins.size() * targets.size(), INFINITE_WEIGHT);
+    const size_t origin_chunk_count = std::min(origins.size(), thread_pool.GetThreadCount());
+    thread_pool.ParallelFor(origin_chunk_count, [&](size_t chunk) {
+        Workspace ws(vertex_count);
+        std::vector<VertexId> settled;
+        for (size_t row = chunk; row < origins.size(); row += origin_chunk_count) {
+            RunUpwardSearch(ws, origins[row], true, settled);
+            Weight* const row_weights = weights.data() + row * targets.size();
+            for (const VertexId vertex : settled) {
+                for (size_t i = bucket_offsets[vertex]; i < bucket_offsets[vertex + 1]; ++i) {
+                    const auto& [column, weight] = buckets[i];
+                    row_weights[column] = std::min(row_weights[column], ws.weights[vertex] + weight);
+                }
+            }
+        }
+    });
+    return weights;
+}
+
+template <typename Weight>
+const typename ContractionHierarchy<Weight>::HierarchyData& ContractionHierarchy<Weight>::GetHierarchyData() const {
+    return hierarchy_data_;
+}
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути алгоритмом Дейкстры на каждый запрос.
+// Память O(V + E): вместо таблицы V x V хранится одно рабочее пространство,
+// которое переиспользуется между запросами и "очищается" сменой эпохи за O(1)
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    // Не потокобезопасен: все запросы используют общее рабочее пространство
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Поиск с весами рёбер edge_weight(edge) вместо записанных в графе
+    template <typename EdgeWeight>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const EdgeWeight& edge_weight) const;
+    // Маршруты из одной вершины во все targets за один поиск
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+    // Все вершины, достижимые из from не дольше чем за max_weight, с весами путей до них.
+    // Вершины дальше max_weight не раскрываются
+    std::vector<std::pair<VertexId, Weight>> BuildReachable(VertexId from, Weight max_weight) const;
+    // Веса маршрутов из каждой origins в каждую targets построчно, INFINITE_WEIGHT - маршрута нет.
+    // Поиски из разных origins идут параллельно, у каждого потока своё рабочее пространство
+    std::vector<Weight> BuildWeights(const std::vector<VertexId>& origins, const std::vector<VertexId>& targets) const;
+
+private:
+    struct Workspace {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> epochs;
+        std::vector<uint32_t> target_epochs;
+        std::vector<std::pair<Weight, VertexId>> heap;
+        uint32_t epoch = 0;
+
+        explicit Workspace(size_t vertex_count)
+            : weights(vertex_count)
+            , prev_edges(vertex_count)
+            , epochs(vertex_count, 0)
+            , target_epochs(vertex_count, 0) {
+        }
+
+        void StartSearch() {
+            heap.clear();
+            if (++epoch == 0) {
+                std::fill(epochs.begin(), epochs.end(), 0);
+                std::fill(target_epochs.begin(), target_epochs.end(), 0);
+                epoch = 1;
+            }
+        }
+
+        // Помечает вершину как цель текущего поиска, возвращает false для повторной пометки
+        bool MarkTarget(VertexId vertex) {
+            if (target_epochs[vertex] == epoch) {
+                return false;
+            }
+            target_epochs[vertex] = epoch;
+            return true;
+        }
+
+        bool IsTarget(VertexId vertex) const {
+            return target_epochs[vertex] == epoch;
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return epochs[vertex] == epoch;
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            epochs[vertex] = epoch;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            heap.emplace_back(weight, vertex);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+    };
+
+    // Поиск из from, пока не будут достигнуты все помеченные цели (target_count штук)
+    template <typename EdgeWeight>
+    void RunSearch(Workspace& ws, size_t target_count, const EdgeWeight& edge_weight) const {
+        while (!ws.heap.empty() && target_count > 0) {
+            std::pop_heap(ws.heap.begin(), ws.heap.end(), std::greater<>{});
+            const auto [weight, vertex] = ws.heap.back();
+            ws.heap.pop_back();
+            if (ws.weights[vertex] < weight) {
+                continue;
+            }
+            if (ws.IsTarget(vertex) && --target_count == 0) {
+                break;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge_weight(edge);
+                if (!ws.IsReached(edge.to) || candidate_weight < ws.weights[edge.to]) {
+                    ws.Reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+    }
+
+    void RunSearch(Workspace& ws, size_t target_count) const {
+        RunSearch(ws, target_count, [](const Edge<Weight>& edge) {
+            return edge.weight;
+        });
+    }
+
+    std::optional<RouteInfo> BuildPath(const Workspace& ws, VertexId to) const {
+        if (!ws.IsReached(to)) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (EdgeId edge_id = ws.prev_edges[to]; edge_id != NO_EDGE;
+            edge_id = ws.prev_edges[graph_.GetEdge(edge_id).from])
+        {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ ws.weights[to], std::move(edges) };
+    }
+
+    void CheckVertex(VertexId vertex) const {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = Router<Weight>::INFINITE_WEIGHT;
+    static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+    const Graph& graph_;
+    mutable Workspace workspace_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , workspace_(graph.GetVertexCount())
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+    VertexId to) const {
+    return BuildRoute(from, to, [](const Edge<Weight>& edge) {
+        return edge.weight;
+    });
+}
+
+template <typename Weight>
+template <typename EdgeWeight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+    VertexId to, const EdgeWeight& edge_weight) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    Workspace& ws = workspace_;
+    ws.StartSearch();
+    ws.MarkTarget(to);
+    ws.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    RunSearch(ws, 1, edge_weight);
+
+    return BuildPath(ws, to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(VertexId from,
+    const std::vector<VertexId>& targets) const {
+    CheckVertex(from);
+    Workspace& ws = workspace_;
+    ws.StartSearch();
+    size_t target_count = 0;
+    for (const VertexId to : targets) {
+        CheckVertex(to);
+        target_count += ws.MarkTarget(to) ? 1 : 0;
+    }
+    ws.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    RunSearch(ws, target_count);
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        routes.push_back(BuildPath(ws, to));
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildReachable(VertexId from, Weight max_weight) const {
+    CheckVertex(from);
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    if (max_weight < ZERO_WEIGHT) {
+        return reachable;
+    }
+    Workspace& ws = workspace_;
+    ws.StartSearch();
+    ws.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    while (!ws.heap.empty()) {
+        std::pop_heap(ws.heap.begin(), ws.heap.end(), std::greater<>{});
+        const auto [weight, vertex] = ws.heap.back();
+        ws.heap.pop_back();
+        if (ws.weights[vertex] < weight) {
+            continue;
+        }
+        reachable.emplace_back(vertex, weight);
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (!(candidate_weight > max_weight) && (!ws.IsReached(edge.to) || candidate_weight < ws.weights[edge.to])) {
+                ws.Reach(edge.to, candidate_weight, edge_id);
+            }
+        }
+    }
+    return reachable;
+}
+
+template <typename Weight>
+std::vector<Weight> DijkstraRouter<Weight>::BuildWeights(const std::vector<VertexId>& origins,
+    const std::vector<VertexId>& targets) const {
+    for (const VertexId from : origins) {
+        CheckVertex(from);
+    }
+    for (const VertexId to : targets) {
+        CheckVertex(to);
+    }
+    std::vector<Weight> weights(origins.size() * targets.size(), INFINITE_WEIGHT);
+    parallel::ThreadPool thread_pool;
+    const size_t chunk_count = std::min(origins.size(), thread_pool.GetThreadCount());
+    thread_pool.ParallelFor(chunk_count, [&](size_t chunk) {
+        Workspace ws(graph_.GetVertexCount());
+        for (size_t row = chunk; row < origins.size(); row += chunk_count) {
+            ws.StartSearch();
+            size_t target_count = 0;
+            for (const VertexId to : targets) {
+                target_count += ws.MarkTarget(to) ? 1 : 0;
+            }
+            ws.Reach(origins[row], ZERO_WEIGHT, NO_EDGE);
+            RunSearch(ws, target_count);
+            for (size_t column = 0; column < targets.size(); ++column) {
+                if (ws.IsReached(targets[column])) {
+                    weights[row * targets.size() + column] = ws.weights[targets[column]];
+                }
+            }
+        }
+    });
+    return weights;
+}
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "distance_table.h"
+
+#include <algorithm>
+
+namespace transport {
+
+// Таблица заполняется не больше чем наполовину: на каждое заданное расстояние
+// приходится до двух слотов (с обратным), а ёмкость - степень двойки
+void DistanceTable::Reserve(size_t count) {
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < count * 4) {
+        capacity *= 2;
+    }
+    if (capacity > slots_.size()) {
+        Rehash(capacity);
+    }
+}
+
+void DistanceTable::Set(uint32_t from, uint32_t to, int distance) {
+    if ((used_slot_count_ + 2) * 2 > slots_.size()) {
+        Rehash(std::max(MIN_CAPACITY, slots_.size() * 2));
+    }
+    {
+        auto [slot, inserted] = Insert(MakeKey(from, to));
+        if (inserted || slot.is_reverse) {
+            ++size_;
+        }
+        slot.distance = distance;
+        slot.is_reverse = false;
+    }
+    auto [reverse_slot, inserted] = Insert(MakeKey(to, from));
+    if (inserted) {
+        reverse_slot.is_reverse = true;
+    }
+    if (reverse_slot.is_reverse) {
+        reverse_slot.distance = distance;
+    }
+}
+
+std::optional<int> DistanceTable::Find(uint32_t from, uint32_t to) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    const Slot& slot = slots_[FindSlot(MakeKey(from, to))];
+    if (slot.key == EMPTY_KEY) {
+        return std::nullopt;
+    }
+    return slot.distance;
+}
+
+size_t DistanceTable::GetSize() const {
+    return size_;
+}
+
+DistanceTable::Iterator DistanceTable::begin() const {
+    return { slots_.data(), slots_.data() + slots_.size() };
+}
+
+DistanceTable::Iterator DistanceTable::end() const {
+    return { slots_.data() + slots_.size(), slots_.data() + slots_.size() };
+}
+
+uint64_t DistanceTable::MakeKey(uint32_t from, uint32_t to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+size_t DistanceTable::FindSlot(uint64_t key) const {
+    const size_t mask = slots_.size() - 1;
+    uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 32;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        if (slots_[index].key == key || slots_[index].key == EMPTY_KEY) {
+            return index;
+        }
+    }
+}
+
+std::pair<DistanceTable::Slot&, bool> DistanceTable::Insert(uint64_t key) {
+    Slot& slot = slots_[FindSlot(key)];
+    if (slot.key != EMPTY_KEY) {
+        return { slot, false };
+    }
+    slot.key = key;
+    ++used_slot_count_;
+    return { slot, true };
+}
+
+void DistanceTable::Rehash(size_t capacity) {
+    std::vector<Slot> old_slots(capacity, Slot{ EMPTY_KEY, 0, false });
+    old_slots.swap(slots_);
+    for (const Slot& old_slot : old_slots) {
+        if (old_slot.key != EMPTY_KEY) {
+            slots_[FindSlot(old_slot.key)] = old_slot;
+        }
+    }
+}
+
+} // namespace transport
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace transport {
+
+// Расстояния по дорогам между остановками: открытая адресация с линейным пробированием
+// по паре id остановок, упакованной в 64-битный ключ. Вместе с заданным расстоянием
+// сразу записывается обратное, если его не задали отдельно, поэтому расстояние
+// в любую сторону находится одним поиском
+class DistanceTable {
+private:
+    struct Slot {
+        uint64_t key;
+        int distance;
+        // Расстояние взято из обратного направления и не было задано явно
+        bool is_reverse;
+    };
+
+public:
+    struct Distance {
+        uint32_t from;
+        uint32_t to;
+        int distance;
+    };
+
+    // Обходит только явно заданные расстояния, без копирования таблицы
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Distance;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Distance*;
+        using reference = Distance;
+
+        Iterator(const Slot* slot, const Slot* end)
+            : slot_(slot)
+            , end_(end) {
+            SkipUnset();
+        }
+
+        Distance operator*() const {
+            return { static_cast<uint32_t>(slot_->key >> 32), static_cast<uint32_t>(slot_->key), slot_->distance };
+        }
+
+        Iterator& operator++() {
+            ++slot_;
+            SkipUnset();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return slot_ == other.slot_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return slot_ != other.slot_;
+        }
+
+    private:
+        const Slot* slot_;
+        const Slot* end_;
+
+        void SkipUnset() {
+            while (slot_ != end_ && (slot_->key == EMPTY_KEY || slot_->is_reverse)) {
+                ++slot_;
+            }
+        }
+    };
+
+    // Готовит таблицу к count заданным расстояниям без перехеширования
+    void Reserve(size_t count);
+    void Set(uint32_t from, uint32_t to, int distance);
+    // Расстояние from -> to, а если оно не задано - to -> from
+    std::optional<int> Find(uint32_t from, uint32_t to) const;
+    // Число явно заданных расстояний
+    size_t GetSize() const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<Slot> slots_;
+    size_t used_slot_count_ = 0;
+    size_t size_ = 0;
+
+    static uint64_t MakeKey(uint32_t from, uint32_t to);
+    // Слот с ключом key или пустой слот, в который он встанет
+    size_t FindSlot(uint64_t key) const;
+    // Слот с ключом key, при отсутствии - занимает пустой. Второе значение - был ли ключ новым
+    std::pair<Slot&, bool> Insert(uint64_t key);
+    void Rehash(size_t capacity);
+};
+
+} // namespace transport
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "geo.h"
+#include "ranges.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <set>
@@ -13,14 +15,21 @@ struct Stop {
     std::string name;
     geo::Coordinates coordinates;
     std::set<std::string> buses_by_stop;
+    // Порядковый номер в справочнике
+    uint32_t id = 0;
 };
 
 struct Bus {
     std::string number;
     std::vector<const Stop*> stops;
     bool is_circle;
+    uint32_t id = 0;
 };
 
+// Диапазоны по упорядоченным массивам справочника, без копирования
+using StopRange = ranges::Range<std::vector<const Stop*>::const_iterator>;
+using BusRange = ranges::Range<std::vector<const Bus*>::const_iterator>;
+
 struct BusStat {
     size_t stops_count;
     size_t unique_stops_count;
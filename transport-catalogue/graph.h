@@ -2,70 +2,272 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 #include <vector>
-#include <string>
 
 namespace graph {
 
 using VertexId = size_t;
 using EdgeId = size_t;
 
+// Компактная запись ребра: вместо названия хранится name_id - номер остановки
+// (для ожидания) или автобуса (для поездки), по которому название берётся из справочника
 template <typename Weight>
 struct Edge {
-    std::string name;
-    size_t quality;
-    VertexId from;
-    VertexId to;
+    uint32_t name_id;
+    uint32_t quality;
+    uint32_t from;
+    uint32_t to;
     Weight weight;
 };
 
+// Результат UpdateEdges: новые id прежних рёбер (NO_EDGE для удалённых) и добавленных рёбер
+struct EdgesUpdate {
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    std::vector<EdgeId> old_edge_ids;
+    std::vector<EdgeId> added_edge_ids;
+};
+
+// Результат UpdateEdgeWeights: рёбра, вес которых вырос, и рёбра, вес которых уменьшился
+struct WeightsUpdate {
+    std::vector<EdgeId> increased_edge_ids;
+    std::vector<EdgeId> decreased_edge_ids;
+};
+
+// Граф строится добавлением рёбер, после чего "замораживается" в формат CSR:
+// рёбра упорядочиваются по начальной вершине в одном массиве, а исходящие рёбра
+// вершины v занимают в нём отрезок [offsets[v], offsets[v + 1])
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = ranges::Range<ranges::CountingIterator<EdgeId>>;
 
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     explicit DirectedWeightedGraph(std::vector<Edge<Weight>> edges,
-        std::vector<std::vector<EdgeId>> incidence_lists);
+        std::vector<EdgeId> offsets);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Переупорядочивает рёбра по начальной вершине, id рёбер при этом меняются
+    void Freeze();
+    // Оставляет для каждой пары вершин (from, to) только самое лёгкое ребро
+    // (из равных - добавленное первым). Возвращает число удалённых рёбер
+    size_t RemoveDominatedEdges();
+    // Удаляет из замороженного графа рёбра, отмеченные в removed, и добавляет рёбра added.
+    // Остальные рёбра переносятся как есть, порядок CSR сохраняется
+    EdgesUpdate UpdateEdges(const std::vector<bool>& removed, const std::vector<Edge<Weight>>& added);
+    // Название ребра не влияет на маршруты, поэтому его можно менять и в замороженном графе
+    void SetEdgeNameId(EdgeId edge_id, uint32_t name_id);
+    // Задаёт новые веса существующим рёбрам, id и порядок рёбер не меняются.
+    // Если ребро встречается несколько раз, действует последний вес
+    WeightsUpdate UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& edge_weights);
 
+    bool IsFrozen() const;
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    const std::vector<EdgeId>& GetOffsets() const;
 
 private:
+    size_t vertex_count_ = 0;
     std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    std::vector<EdgeId> offsets_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count) {
 }
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(std::vector<Edge<Weight>> edges,
-    std::vector<std::vector<EdgeId>> incidence_lists)
-    : edges_(edges)
-    , incidence_lists_(incidence_lists) {
+    std::vector<EdgeId> offsets)
+    : vertex_count_(offsets.empty() ? 0 : offsets.size() - 1)
+    , edges_(std::move(edges))
+    , offsets_(std::move(offsets)) {
+    if (offsets_.empty() || offsets_.back() != edges_.size()) {
+        throw std::invalid_argument("Offsets don't match the edges");
+    }
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (IsFrozen()) {
+        throw std::logic_error("Graph is frozen");
+    }
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    return edges_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+        return;
+    }
+    offsets_.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : edges_) {
+        ++offsets_[edge.from + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+    std::vector<Edge<Weight>> sorted_edges(edges_.size());
+    std::vector<EdgeId> positions(offsets_.begin(), offsets_.end() - 1);
+    for (const auto& edge : edges_) {
+        sorted_edges[positions[edge.from]++] = edge;
+    }
+    edges_ = std::move(sorted_edges);
+}
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::RemoveDominatedEdges() {
+    Freeze();
+    std::vector<Edge<Weight>> kept_edges;
+    kept_edges.reserve(edges_.size());
+    std::vector<EdgeId> kept_offsets(vertex_count_ + 1, 0);
+    std::vector<EdgeId> order;
+    std::vector<bool> is_kept;
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        const EdgeId begin = offsets_[vertex];
+        const EdgeId end = offsets_[vertex + 1];
+        order.resize(end - begin);
+        for (EdgeId edge_id = begin; edge_id < end; ++edge_id) {
+            order[edge_id - begin] = edge_id;
+        }
+        std::sort(order.begin(), order.end(), [this](EdgeId lhs, EdgeId rhs) {
+            const auto& lhs_edge = edges_[lhs];
+            const auto& rhs_edge = edges_[rhs];
+            if (lhs_edge.to != rhs_edge.to) return lhs_edge.to < rhs_edge.to;
+            if (lhs_edge.weight != rhs_edge.weight) return lhs_edge.weight < rhs_edge.weight;
+            return lhs < rhs;
+        });
+        is_kept.assign(end - begin, false);
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (i == 0 || edges_[order[i]].to != edges_[order[i - 1]].to) {
+                is_kept[order[i] - begin] = true;
+            }
+        }
+        for (EdgeId edge_id = begin; edge_id < end; ++edge_id) {
+            if (is_kept[edge_id - begin]) {
+                kept_edges.push_back(edges_[edge_id]);
+            }
+        }
+        kept_offsets[vertex + 1] = kept_edges.size();
+    }
+    const size_t removed_count = edges_.size() - kept_edges.size();
+    edges_ = std::move(kept_edges);
+    offsets_ = std::move(kept_offsets);
+    return removed_count;
+}
+
+template <typename Weight>
+EdgesUpdate DirectedWeightedGraph<Weight>::UpdateEdges(const std::vector<bool>& removed,
+    const std::vector<Edge<Weight>>& added) {
+    if (!IsFrozen()) {
+        throw std::logic_error("Graph is not frozen");
+    }
+    if (removed.size() != edges_.size()) {
+        throw std::invalid_argument("Removed flags don't match the edges");
+    }
+    std::vector<EdgeId> added_offsets(vertex_count_ + 1, 0);
+    for (const auto& edge : added) {
+        if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        ++added_offsets[edge.from + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        added_offsets[vertex + 1] += added_offsets[vertex];
+    }
+    std::vector<EdgeId> added_order(added.size());
+    std::vector<EdgeId> positions(added_offsets.begin(), added_offsets.end() - 1);
+    for (EdgeId added_id = 0; added_id < added.size(); ++added_id) {
+        added_order[positions[added[added_id].from]++] = added_id;
+    }
+
+    EdgesUpdate update{ std::vector<EdgeId>(edges_.size(), EdgesUpdate::NO_EDGE), std::vector<EdgeId>(added.size()) };
+    std::vector<Edge<Weight>> updated_edges;
+    updated_edges.reserve(edges_.size() + added.size());
+    std::vector<EdgeId> updated_offsets(vertex_count_ + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        for (EdgeId edge_id = offsets_[vertex]; edge_id < offsets_[vertex + 1]; ++edge_id) {
+            if (!removed[edge_id]) {
+                update.old_edge_ids[edge_id] = updated_edges.size();
+                updated_edges.push_back(edges_[edge_id]);
+            }
+        }
+        for (EdgeId i = added_offsets[vertex]; i < added_offsets[vertex + 1]; ++i) {
+            update.added_edge_ids[added_order[i]] = updated_edges.size();
+            updated_edges.push_back(added[added_order[i]]);
+        }
+        updated_offsets[vertex + 1] = updated_edges.size();
+    }
+    edges_ = std::move(updated_edges);
+    offsets_ = std::move(updated_offsets);
+    return update;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeNameId(EdgeId edge_id, uint32_t name_id) {
+    edges_.at(edge_id).name_id = name_id;
+}
+
+template <typename Weight>
+WeightsUpdate DirectedWeightedGraph<Weight>::UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& edge_weights) {
+    for (const auto& [edge_id, weight] : edge_weights) {
+        if (edge_id >= edges_.size()) {
+            throw std::out_of_range("Edge id is out of range");
+        }
+        if (weight < Weight{}) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    // Прежние веса изменяемых рёбер по возрастанию id
+    std::vector<std::pair<EdgeId, Weight>> old_weights;
+    old_weights.reserve(edge_weights.size());
+    for (const auto& [edge_id, weight] : edge_weights) {
+        old_weights.emplace_back(edge_id, edges_[edge_id].weight);
+    }
+    std::stable_sort(old_weights.begin(), old_weights.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    old_weights.erase(std::unique(old_weights.begin(), old_weights.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first == rhs.first;
+    }), old_weights.end());
+    for (const auto& [edge_id, weight] : edge_weights) {
+        edges_[edge_id].weight = weight;
+    }
+
+    WeightsUpdate update;
+    for (const auto& [edge_id, old_weight] : old_weights) {
+        if (edges_[edge_id].weight > old_weight) {
+            update.increased_edge_ids.push_back(edge_id);
+        }
+        else if (edges_[edge_id].weight < old_weight) {
+            update.decreased_edge_ids.push_back(edge_id);
+        }
+    }
+    return update;
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return !offsets_.empty();
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
@@ -81,7 +283,15 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (!IsFrozen()) {
+        throw std::logic_error("Graph is not frozen");
+    }
+    return ranges::AsCountingRange(offsets_.at(vertex), offsets_.at(vertex + 1));
+}
+
+template <typename Weight>
+const std::vector<EdgeId>& DirectedWeightedGraph<Weight>::GetOffsets() const {
+    return offsets_;
 }
 
 } // namespace graph
\ No newline at end of file
@@ -30,63 +30,122 @@ const json::Node& JsonReader::GetSerializationSettings() const {
 
 void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const {
     json::Array result;
-    for (auto& request : stat_requests.AsArray()) {
-        const auto& request_map = request.AsDict();
+    const json::Array& requests = stat_requests.AsArray();
+    const auto routings = FindRoutings(requests, rh);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto& request_map = requests[i].AsDict();
         const auto& type = request_map.at("type"s).AsString();
         if (type == "Stop"s) result.push_back(PrintStop(request_map, rh).AsDict());
         if (type == "Bus"s) result.push_back(PrintRoute(request_map, rh).AsDict());
         if (type == "Map"s) result.push_back(PrintMap(request_map, rh).AsDict());
-        if (type == "Route"s) result.push_back(PrintRouting(request_map, rh).AsDict());
+        if (type == "Route"s) {
+            const transport::RoutingOverrides overrides = ReadRoutingOverrides(request_map);
+            if (overrides.bus_wait_time || overrides.bus_velocity) result.push_back(PrintRouting(request_map, rh).AsDict());
+            else result.push_back(PrintRouting(request_map, routings[i], rh).AsDict());
+        }
+        if (type == "Isochrone"s) result.push_back(PrintIsochrone(request_map, rh).AsDict());
+        if (type == "RouteMatrix"s) result.push_back(PrintRouteMatrix(request_map, rh).AsDict());
     }
 
     json::Print(json::Document{ result }, std::cout);
 }
 
-void JsonReader::FillCatalogue(transport::Catalogue& catalogue) {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops : arr) {
-        const auto& request_stops_map = request_stops.AsDict();
-        const auto& type = request_stops_map.at("type"s).AsString();
-        if (type == "Stop"s) {
-            auto [stop_name, coordinates, stop_distances] = FillStop(request_stops_map);
-            catalogue.AddStop(stop_name, coordinates);
-        }
+// Запросы Route с общей остановкой отправления считаются одним пакетом, кроме запросов
+// с собственными параметрами движения. Результат индексирован позицией запроса в stat_requests
+std::vector<std::optional<transport::RouteInfo>> JsonReader::FindRoutings(const json::Array& requests, RequestHandler& rh) const {
+    std::vector<std::string_view> origins;
+    std::unordered_map<std::string_view, std::vector<size_t>> positions_by_origin;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto& request_map = requests[i].AsDict();
+        if (request_map.at("type"s).AsString() != "Route"s) continue;
+        const transport::RoutingOverrides overrides = ReadRoutingOverrides(request_map);
+        if (overrides.bus_wait_time || overrides.bus_velocity) continue;
+        const std::string_view stop_from = request_map.at("from"s).AsString();
+        auto& positions = positions_by_origin[stop_from];
+        if (positions.empty()) origins.push_back(stop_from);
+        positions.push_back(i);
     }
-    FillStopDistances(catalogue);
 
-    for (auto& request_bus : arr) {
-        const auto& request_bus_map = request_bus.AsDict();
-        const auto& type = request_bus_map.at("type"s).AsString();
-        if (type == "Bus"s) {
-            auto [bus_number, stops, circular_route] = FillRoute(request_bus_map, catalogue);
-            catalogue.AddRoute(bus_number, stops, circular_route);
+    std::vector<std::optional<transport::RouteInfo>> routings(requests.size());
+    for (const std::string_view stop_from : origins) {
+        const auto& positions = positions_by_origin.at(stop_from);
+        std::vector<std::string_view> stops_to;
+        stops_to.reserve(positions.size());
+        for (const size_t position : positions) {
+            stops_to.push_back(requests[position].AsDict().at("to"s).AsString());
+        }
+        auto routes = rh.GetOptimalRoutes(stop_from, stops_to);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            routings[positions[i]] = std::move(routes[i]);
         }
     }
+    return routings;
 }
 
-std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> JsonReader::FillStop(const json::Dict& request_map) const {
-    std::string_view stop_name = request_map.at("name"s).AsString();
-    geo::Coordinates coordinates = { request_map.at("latitude"s).AsDouble(), request_map.at("longitude"s).AsDouble() };
-    std::map<std::string_view, int> stop_distances;
-    auto& distances = request_map.at("road_distances"s).AsDict();
-    for (auto& [stop_name, dist] : distances) {
-        stop_distances.emplace(stop_name, dist.AsInt());
+// Названия остановок переводятся в id здесь, справочник дальше работает только с id
+void JsonReader::FillCatalogue(transport::Catalogue& catalogue) {
+    const json::Array& arr = GetBaseRequests().AsArray();
+    std::vector<transport::Catalogue::StopEntry> stops;
+    for (auto& request : arr) {
+        const auto& request_map = request.AsDict();
+        if (request_map.at("type"s).AsString() == "Stop"s) {
+            stops.push_back({ request_map.at("name"s).AsString(),
+                { request_map.at("latitude"s).AsDouble(), request_map.at("longitude"s).AsDouble() } });
+        }
     }
-    return std::make_tuple(stop_name, coordinates, stop_distances);
-}
+    catalogue.AddStops(stops);
 
-void JsonReader::FillStopDistances(transport::Catalogue& catalogue) const {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops : arr) {
-        const auto& request_stops_map = request_stops.AsDict();
-        const auto& type = request_stops_map.at("type"s).AsString();
+    const auto stop_id = [&catalogue](std::string_view stop_name) {
+        const transport::Stop* stop = catalogue.FindStop(stop_name);
+        if (!stop) {
+            throw std::out_of_range("Unknown stop "s + std::string(stop_name));
+        }
+        return stop->id;
+    };
+    std::vector<transport::Catalogue::DistanceEntry> distances;
+    std::vector<transport::Catalogue::BusEntry> buses;
+    for (auto& request : arr) {
+        const auto& request_map = request.AsDict();
+        const auto& type = request_map.at("type"s).AsString();
         if (type == "Stop"s) {
-            auto [stop_name, coordinates, stop_distances] = FillStop(request_stops_map);
-            for (auto& [to_name, dist] : stop_distances) {
-                auto from = catalogue.FindStop(stop_name);
-                auto to = catalogue.FindStop(to_name);
-                catalogue.SetDistance(from, to, dist);
+            const uint32_t from = stop_id(request_map.at("name"s).AsString());
+            for (const auto& [to_name, dist] : request_map.at("road_distances"s).AsDict()) {
+                distances.push_back({ from, stop_id(to_name), dist.AsInt() });
+            }
+        }
+        else if (type == "Bus"s) {
+            transport::Catalogue::BusEntry bus{ request_map.at("name"s).AsString(), {}, request_map.at("is_roundtrip"s).AsBool(), std::nullopt };
+            const json::Array& stop_names = request_map.at("stops"s).AsArray();
+            bus.stops.reserve(stop_names.size());
+            for (const auto& stop : stop_names) {
+                bus.stops.push_back(stop_id(stop.AsString()));
+            }
+            buses.push_back(std::move(bus));
+        }
+    }
+    catalogue.AddDistances(distances);
+    catalogue.AddRoutes(buses);
+}
+
+void JsonReader::UpdateCatalogue(transport::Catalogue& catalogue) const {
+    for (auto& request : GetBaseRequests().AsArray()) {
+        const auto& request_map = request.AsDict();
+        const auto& type = request_map.at("type"s).AsString();
+        if (type == "Bus"s) {
+            auto [bus_number, stops, circular_route] = FillRoute(request_map, catalogue);
+            if (std::count(stops.begin(), stops.end(), nullptr)) {
+                throw std::logic_error("Bus "s + std::string(bus_number) + " uses an unknown stop"s);
+            }
+            if (catalogue.FindRoute(bus_number)) {
+                catalogue.RemoveRoute(bus_number);
             }
+            catalogue.AddRoute(bus_number, stops, circular_route);
+        }
+        else if (type == "RemoveBus"s) {
+            catalogue.RemoveRoute(request_map.at("name"s).AsString());
+        }
+        else {
+            throw std::logic_error("Unsupported base update request: "s + type);
         }
     }
 }
@@ -151,9 +210,44 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Node& settings)
     return render_settings;
 }
 
-transport::Router JsonReader::FillRoutingSettings(const json::Node& settings) const {
-    //transport::Router routing_settings;
-    return transport::Router{ settings.AsDict().at("bus_wait_time"s).AsInt(), settings.AsDict().at("bus_velocity"s).AsDouble() };
+transport::RoutingSettings JsonReader::FillRoutingSettings(const json::Node& settings) const {
+    const json::Dict& request_map = settings.AsDict();
+    transport::RoutingSettings routing_settings;
+    routing_settings.bus_wait_time = request_map.at("bus_wait_time"s).AsInt();
+    routing_settings.bus_velocity = request_map.at("bus_velocity"s).AsDouble();
+    if (request_map.count("routing_mode"s)) {
+        const std::string& routing_mode = request_map.at("routing_mode"s).AsString();
+        if (routing_mode == "all_pairs"s) routing_settings.routing_mode = transport::RoutingMode::ALL_PAIRS;
+        else if (routing_mode == "dijkstra"s) routing_settings.routing_mode = transport::RoutingMode::DIJKSTRA;
+        else if (routing_mode == "contraction_hierarchy"s) routing_settings.routing_mode = transport::RoutingMode::CONTRACTION_HIERARCHY;
+        else if (routing_mode == "raptor"s) routing_settings.routing_mode = transport::RoutingMode::RAPTOR;
+        else throw std::logic_error("wrong routing_mode"s);
+    }
+    if (request_map.count("prune_dominated_edges"s)) {
+        routing_settings.prune_dominated_edges = request_map.at("prune_dominated_edges"s).AsBool();
+    }
+    if (request_map.count("compact_routes_table"s)) {
+        routing_settings.compact_routes_table = request_map.at("compact_routes_table"s).AsBool();
+    }
+    if (request_map.count("vertex_order"s)) {
+        const std::string& vertex_order = request_map.at("vertex_order"s).AsString();
+        if (vertex_order == "name"s) routing_settings.vertex_order = transport::VertexOrder::NAME;
+        else if (vertex_order == "reverse_cuthill_mckee"s) routing_settings.vertex_order = transport::VertexOrder::REVERSE_CUTHILL_MCKEE;
+        else if (vertex_order == "hilbert_curve"s) routing_settings.vertex_order = transport::VertexOrder::HILBERT_CURVE;
+        else throw std::logic_error("wrong vertex_order"s);
+    }
+    if (request_map.count("graph_layout"s)) {
+        const std::string& graph_layout = request_map.at("graph_layout"s).AsString();
+        if (graph_layout == "stop_pairs"s) routing_settings.graph_layout = transport::GraphLayout::STOP_PAIRS;
+        else if (graph_layout == "route_patterns"s) routing_settings.graph_layout = transport::GraphLayout::ROUTE_PATTERNS;
+        else throw std::logic_error("wrong graph_layout"s);
+    }
+    if (request_map.count("route_cache_size"s)) {
+        const int route_cache_size = request_map.at("route_cache_size"s).AsInt();
+        if (route_cache_size < 0) throw std::logic_error("wrong route_cache_size"s);
+        routing_settings.route_cache_size = static_cast<size_t>(route_cache_size);
+    }
+    return routing_settings;
 }
 
 const json::Node JsonReader::PrintRoute(const json::Dict& request_map, RequestHandler& rh) const {
@@ -212,6 +306,82 @@ const json::Node JsonReader::PrintStop(const json::Dict& request_map, RequestHan
     return result;
 }
 
+const json::Node JsonReader::PrintIsochrone(const json::Dict& request_map, RequestHandler& rh) const {
+    json::Node result;
+    const std::string& stop_from = request_map.at("from"s).AsString();
+    const int id = request_map.at("id"s).AsInt();
+
+    if (!rh.IsStopName(stop_from)) {
+        result = json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("error_message"s).Value("not found"s)
+            .EndDict()
+        .Build();
+    }
+    else {
+        json::Array items;
+        for (const auto& [stop, time] : rh.GetReachableStops(stop_from, request_map.at("max_time"s).AsDouble())) {
+            items.emplace_back(json::Node(json::Builder{}
+                .StartDict()
+                    .Key("stop_name"s).Value(stop->name)
+                    .Key("time"s).Value(time)
+                .EndDict()
+            .Build()));
+        }
+        result = json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("items"s).Value(items)
+            .EndDict()
+        .Build();
+    }
+    return result;
+}
+
+// Времена лежат одним массивом построчно: total_times[i * destinations.size() + j] -
+// из origins[i] в destinations[j], null - маршрута нет
+const json::Node JsonReader::PrintRouteMatrix(const json::Dict& request_map, RequestHandler& rh) const {
+    json::Node result;
+    const int id = request_map.at("id"s).AsInt();
+    const auto read_stops = [](const json::Node& node) {
+        std::vector<std::string_view> stops;
+        for (const auto& stop : node.AsArray()) {
+            stops.push_back(stop.AsString());
+        }
+        return stops;
+    };
+    const std::vector<std::string_view> stops_from = read_stops(request_map.at("origins"s));
+    const std::vector<std::string_view> stops_to = read_stops(request_map.at("destinations"s));
+    const auto is_stop_name = [&rh](std::string_view stop) {
+        return rh.IsStopName(stop);
+    };
+
+    if (!std::all_of(stops_from.begin(), stops_from.end(), is_stop_name) || !std::all_of(stops_to.begin(), stops_to.end(), is_stop_name)) {
+        result = json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("error_message"s).Value("not found"s)
+            .EndDict()
+        .Build();
+    }
+    else {
+        json::Array total_times;
+        const std::vector<double> times = rh.GetTravelTimes(stops_from, stops_to);
+        total_times.reserve(times.size());
+        for (const double time : times) {
+            total_times.emplace_back(time == std::numeric_limits<double>::infinity() ? json::Node(nullptr) : json::Node(time));
+        }
+        result = json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("total_times"s).Value(total_times)
+            .EndDict()
+        .Build();
+    }
+    return result;
+}
+
 const json::Node JsonReader::PrintMap(const json::Dict& request_map, RequestHandler& rh) const {
     json::Node result;
     const int id = request_map.at("id"s).AsInt();
@@ -230,11 +400,31 @@ const json::Node JsonReader::PrintMap(const json::Dict& request_map, RequestHand
 }
 
 const json::Node JsonReader::PrintRouting(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const int id = request_map.at("id"s).AsInt();
     const std::string_view stop_from = request_map.at("from"s).AsString();
     const std::string_view stop_to = request_map.at("to"s).AsString();
-    const auto& routing = rh.GetOptimalRoute(stop_from, stop_to);
+    return PrintRouting(request_map, rh.GetOptimalRoute(stop_from, stop_to, ReadRoutingOverrides(request_map)), rh);
+}
+
+// Необязательные bus_wait_time и bus_velocity запроса Route
+transport::RoutingOverrides JsonReader::ReadRoutingOverrides(const json::Dict& request_map) const {
+    transport::RoutingOverrides overrides;
+    if (request_map.count("bus_wait_time"s)) {
+        const int bus_wait_time = request_map.at("bus_wait_time"s).AsInt();
+        if (bus_wait_time < 0) throw std::logic_error("wrong bus_wait_time"s);
+        overrides.bus_wait_time = bus_wait_time;
+    }
+    if (request_map.count("bus_velocity"s)) {
+        const double bus_velocity = request_map.at("bus_velocity"s).AsDouble();
+        if (!(bus_velocity > 0.0)) throw std::logic_error("wrong bus_velocity"s);
+        overrides.bus_velocity = bus_velocity;
+    }
+    return overrides;
+}
+
+const json::Node JsonReader::PrintRouting(const json::Dict& request_map, const std::optional<transport::RouteInfo>& routing,
+    RequestHandler& rh) const {
+    json::Node result;
+    const int id = request_map.at("id"s).AsInt();
     
     if (!routing) {
         result = json::Builder{}
@@ -248,12 +438,11 @@ const json::Node JsonReader::PrintRouting(const json::Dict& request_map, Request
         json::Array items;
         double total_time = 0.0;
         items.reserve(routing.value().edges.size());
-        for (auto& edge_id : routing.value().edges) {
-            const graph::Edge<double> edge = rh.GetRouterGraph().GetEdge(edge_id);
+        for (const graph::Edge<double>& edge : routing.value().edges) {
             if (edge.quality == 0) {
                 items.emplace_back(json::Node(json::Builder{}
                     .StartDict()
-                        .Key("stop_name"s).Value(edge.name)
+                        .Key("stop_name"s).Value(std::string(rh.GetEdgeName(edge)))
                         .Key("time"s).Value(edge.weight)
                         .Key("type"s).Value("Wait"s)
                     .EndDict()
@@ -264,7 +453,7 @@ const json::Node JsonReader::PrintRouting(const json::Dict& request_map, Request
             else {
                 items.emplace_back(json::Node(json::Builder{}
                     .StartDict()
-                        .Key("bus"s).Value(edge.name)
+                        .Key("bus"s).Value(std::string(rh.GetEdgeName(edge)))
                         .Key("span_count"s).Value(static_cast<int>(edge.quality))
                         .Key("time"s).Value(edge.weight)
                         .Key("type"s).Value("Bus"s)
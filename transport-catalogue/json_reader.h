@@ -5,7 +5,12 @@
 #include "map_renderer.h"
 #include "request_handler.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 class JsonReader {
 public:
@@ -22,19 +27,25 @@ public:
     void ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const;
 
     void FillCatalogue(transport::Catalogue& catalogue);
+    // Применяет к готовому справочнику изменения автобусов из base_requests:
+    // Bus добавляет или заменяет автобус, RemoveBus удаляет его
+    void UpdateCatalogue(transport::Catalogue& catalogue) const;
     renderer::MapRenderer FillRenderSettings(const json::Node& settings) const;
-    transport::Router FillRoutingSettings(const json::Node& settings) const;
+    transport::RoutingSettings FillRoutingSettings(const json::Node& settings) const;
 
     const json::Node PrintRoute(const json::Dict& request_map, RequestHandler& rh) const;
     const json::Node PrintStop(const json::Dict& request_map, RequestHandler& rh) const;
     const json::Node PrintMap(const json::Dict& request_map, RequestHandler& rh) const;
     const json::Node PrintRouting(const json::Dict& request_map, RequestHandler& rh) const;
+    const json::Node PrintIsochrone(const json::Dict& request_map, RequestHandler& rh) const;
+    const json::Node PrintRouteMatrix(const json::Dict& request_map, RequestHandler& rh) const;
+    transport::RoutingOverrides ReadRoutingOverrides(const json::Dict& request_map) const;
+    const json::Node PrintRouting(const json::Dict& request_map, const std::optional<transport::RouteInfo>& routing, RequestHandler& rh) const;
 
 private:
     json::Document input_;
     json::Node dummy_ = nullptr;
 
-    std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> FillStop(const json::Dict& request_map) const;
-    void FillStopDistances(transport::Catalogue& catalogue) const;
+    std::vector<std::optional<transport::RouteInfo>> FindRoutings(const json::Array& requests, RequestHandler& rh) const;
     std::tuple<std::string_view, std::vector<const transport::Stop*>, bool> FillRoute(const json::Dict& request_map, transport::Catalogue& catalogue) const;
 };
\ No newline at end of file
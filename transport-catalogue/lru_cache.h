@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cache {
+
+// Ограниченный по размеру LRU-кэш, разбитый на сегменты со своими мьютексами,
+// чтобы параллельные обращения к разным ключам не ждали друг друга.
+// При переполнении сегмента вытесняется давно не использованный элемент
+template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+class LruCache {
+public:
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    explicit LruCache(size_t capacity, size_t shard_count = DEFAULT_SHARD_COUNT)
+        : capacity_(capacity)
+        , shards_(capacity > 0 ? std::min(shard_count, capacity) : 1) {
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            // Ёмкость распределяется по сегментам так, чтобы в сумме не превысить capacity
+            shards_[i].capacity = capacity / shards_.size() + (i < capacity % shards_.size() ? 1 : 0);
+        }
+    }
+
+    std::optional<Value> Find(const Key& key) {
+        Shard& shard = GetShard(key);
+        std::lock_guard lock(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            ++miss_count_;
+            return std::nullopt;
+        }
+        ++hit_count_;
+        shard.items.splice(shard.items.begin(), shard.items, it->second);
+        return it->second->second;
+    }
+
+    void Put(const Key& key, Value value) {
+        Shard& shard = GetShard(key);
+        if (shard.capacity == 0) {
+            return;
+        }
+        std::lock_guard lock(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.items.splice(shard.items.begin(), shard.items, it->second);
+            return;
+        }
+        if (shard.items.size() == shard.capacity) {
+            shard.index.erase(shard.items.back().first);
+            shard.items.pop_back();
+        }
+        shard.items.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.items.begin());
+    }
+
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+    size_t GetHitCount() const {
+        return hit_count_;
+    }
+
+    size_t GetMissCount() const {
+        return miss_count_;
+    }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        size_t capacity = 0;
+        std::list<std::pair<Key, Value>> items;
+        std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hasher> index;
+    };
+
+    // Сегмент выбирается по старшим битам хеша: младшие биты достаются индексу внутри сегмента
+    Shard& GetShard(const Key& key) {
+        const uint64_t hash = static_cast<uint64_t>(Hasher{}(key)) * 0x9E3779B97F4A7C15ull;
+        return shards_[(hash >> 32) % shards_.size()];
+    }
+
+    size_t capacity_;
+    std::vector<Shard> shards_;
+    std::atomic<size_t> hit_count_{ 0 };
+    std::atomic<size_t> miss_count_{ 0 };
+};
+
+} // namespace cache
\ No newline at end of file
@@ -9,7 +9,7 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -36,13 +36,32 @@ int main(int argc, char* argv[]) {
             serialization::Serialize(catalogue, renderer, router, fout);
         }
 }
+    else if (mode == "update_base"sv) {
+        JsonReader json_input(std::cin);
+        const std::string& file = json_input.GetSerializationSettings().AsDict().at("file"s).AsString();
+        std::ifstream db_file(file, std::ios::binary);
+        if (db_file) {
+            auto [catalogue, renderer, router, graph, stop_vertices, load_router_data] = serialization::Deserialize(db_file);
+            db_file.close();
+            router.SetGraph(catalogue, std::move(graph), std::move(stop_vertices), std::move(load_router_data));
+            json_input.UpdateCatalogue(catalogue);
+            router.UpdateBuses(catalogue);
+
+            std::ofstream fout(file, std::ios::binary);
+            if (fout.is_open()) {
+                serialization::Serialize(catalogue, renderer, router, fout);
+            }
+        }
+    }
     else if (mode == "process_requests"sv) {
         JsonReader json_input(std::cin);
         std::ifstream db_file(json_input.GetSerializationSettings().AsDict().at("file"s).AsString(), std::ios::binary);
         if (db_file) {
-            auto [catalogue, renderer, router, graph, stop_ids] = serialization::Deserialize(db_file);
+            auto [catalogue, renderer, router, graph, stop_vertices, load_router_data] = serialization::Deserialize(db_file);
             const auto& stat_requests = json_input.GetStatRequests();
-            router.SetGraph(graph, stop_ids);
+            // Таблица маршрутов или иерархия разбираются из базы и собираются в фоне, запросы Bus, Stop и Map
+            // их не ждут. Маршруты до готовности движка ищет DijkstraRouter, в режиме RAPTOR - ждут движок
+            router.SetGraphInBackground(catalogue, std::move(graph), std::move(stop_vertices), std::move(load_router_data));
             RequestHandler rh = { catalogue, renderer, router };
             
             json_input.ProcessRequests(stat_requests, rh);
@@ -6,10 +6,10 @@ bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
-std::vector<svg::Polyline> MapRenderer::GetRouteLines(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const {
+std::vector<svg::Polyline> MapRenderer::GetRouteLines(const transport::BusRange& buses, const SphereProjector& sp) const {
     std::vector<svg::Polyline> result;
     size_t color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
+    for (const transport::Bus* bus : buses) {
         if (bus->stops.empty()) continue;
         std::vector<const transport::Stop*> route_stops{ bus->stops.begin(), bus->stops.end() };
         if (bus->is_circle == false) route_stops.insert(route_stops.end(), std::next(bus->stops.rbegin()), bus->stops.rend());
@@ -32,10 +32,10 @@ std::vector<svg::Polyline> MapRenderer::GetRouteLines(const std::map<std::string
     return result;
 }
 
-std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const {
+std::vector<svg::Text> MapRenderer::GetBusLabel(const transport::BusRange& buses, const SphereProjector& sp) const {
     std::vector<svg::Text> result;
     size_t color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
+    for (const transport::Bus* bus : buses) {
         if (bus->stops.empty()) continue;
         svg::Text text;
         svg::Text underlayer;
@@ -78,9 +78,9 @@ std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view,
     return result;
 }
 
-std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const {
+std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const transport::StopRange& stops, const SphereProjector& sp) const {
     std::vector<svg::Circle> result;
-    for (const auto& [stop_name, stop] : stops) {
+    for (const transport::Stop* stop : stops) {
         svg::Circle symbol;
         symbol.SetCenter(sp(stop->coordinates));
         symbol.SetRadius(render_settings_.stop_radius);
@@ -92,11 +92,11 @@ std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::map<std::string
     return result;
 }
 
-std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const {
+std::vector<svg::Text> MapRenderer::GetStopsLabels(const transport::StopRange& stops, const SphereProjector& sp) const {
     std::vector<svg::Text> result;
     svg::Text text;
     svg::Text underlayer;
-    for (const auto& [stop_name, stop] : stops) {
+    for (const transport::Stop* stop : stops) {
         text.SetPosition(sp(stop->coordinates));
         text.SetOffset(render_settings_.stop_label_offset);
         text.SetFontSize(render_settings_.stop_label_font_size);
@@ -122,24 +122,25 @@ std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::map<std::string_vi
     return result;
 }
 
-svg::Document MapRenderer::GetSVG(const std::map<std::string_view, const transport::Bus*>& buses) const {
+svg::Document MapRenderer::GetSVG(const transport::BusRange& buses, const transport::StopRange& stops) const {
     svg::Document result;
     std::vector<geo::Coordinates> route_stops_coord;
-    std::map<std::string_view, const transport::Stop*> all_stops;
+    std::vector<const transport::Stop*> route_stops;
 
-    for (const auto& [bus_number, bus] : buses) {
-        if (bus->stops.empty()) continue;
+    for (const transport::Bus* bus : buses) {
         for (const auto& stop : bus->stops) {
             route_stops_coord.push_back(stop->coordinates);
-            all_stops[stop->name] = stop;
         }
     }
+    for (const transport::Stop* stop : stops) {
+        if (!stop->buses_by_stop.empty()) route_stops.push_back(stop);
+    }
     SphereProjector sp(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
 
     for (const auto& line : GetRouteLines(buses, sp)) result.Add(line);
     for (const auto& text : GetBusLabel(buses, sp)) result.Add(text);
-    for (const auto& circle : GetStopsSymbols(all_stops, sp)) result.Add(circle);
-    for (const auto& text : GetStopsLabels(all_stops, sp)) result.Add(text);
+    for (const auto& circle : GetStopsSymbols(ranges::AsRange(route_stops), sp)) result.Add(circle);
+    for (const auto& text : GetStopsLabels(ranges::AsRange(route_stops), sp)) result.Add(text);
 
     return result;
 }
@@ -104,12 +104,13 @@ public:
         : render_settings_(render_settings)
     {}
 
-    std::vector<svg::Polyline> GetRouteLines(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const;
-    std::vector<svg::Text> GetBusLabel(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const;
-    std::vector<svg::Circle> GetStopsSymbols(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const;
-    std::vector<svg::Text> GetStopsLabels(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const;
+    std::vector<svg::Polyline> GetRouteLines(const transport::BusRange& buses, const SphereProjector& sp) const;
+    std::vector<svg::Text> GetBusLabel(const transport::BusRange& buses, const SphereProjector& sp) const;
+    std::vector<svg::Circle> GetStopsSymbols(const transport::StopRange& stops, const SphereProjector& sp) const;
+    std::vector<svg::Text> GetStopsLabels(const transport::StopRange& stops, const SphereProjector& sp) const;
 
-    svg::Document GetSVG(const std::map<std::string_view, const transport::Bus*>& buses) const;
+    // buses и stops упорядочены по названиям; рисуются только остановки, через которые идут автобусы
+    svg::Document GetSVG(const transport::BusRange& buses, const transport::StopRange& stops) const;
 
     const RenderSettings GetRenderSettings() const;
 
@@ -0,0 +1,191 @@
+#include "raptor_router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace transport {
+
+RaptorRouter::RaptorRouter(size_t stop_count, std::vector<RoutePattern> patterns, double bus_wait_time, double bus_velocity)
+    : stop_count_(stop_count)
+    , patterns_(std::move(patterns))
+    , stop_patterns_(stop_count)
+    , timing_{ bus_wait_time, bus_velocity * (100.0 / 6.0) }
+    , workspace_(stop_count_, patterns_.size())
+{
+    for (uint32_t pattern_id = 0; pattern_id < patterns_.size(); ++pattern_id) {
+        const auto& stops = patterns_[pattern_id].stops;
+        if (stops.size() != patterns_[pattern_id].distances.size()) {
+            throw std::invalid_argument("Route pattern distances don't match its stops");
+        }
+        for (uint32_t index = 0; index < stops.size(); ++index) {
+            CheckStop(stops[index]);
+            stop_patterns_[stops[index]].emplace_back(pattern_id, index);
+        }
+    }
+}
+
+std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(uint32_t from, uint32_t to) const {
+    CheckStop(from);
+    CheckStop(to);
+    RunSearch(workspace_, timing_, from, to);
+    return BuildJourney(timing_, to);
+}
+
+std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(uint32_t from, uint32_t to, double bus_wait_time, double bus_velocity) const {
+    CheckStop(from);
+    CheckStop(to);
+    const Timing timing{ bus_wait_time, bus_velocity * (100.0 / 6.0) };
+    RunSearch(workspace_, timing, from, to);
+    return BuildJourney(timing, to);
+}
+
+std::vector<std::optional<RaptorRouter::Journey>> RaptorRouter::BuildRoutes(uint32_t from, const std::vector<uint32_t>& targets) const {
+    CheckStop(from);
+    for (const uint32_t to : targets) {
+        CheckStop(to);
+    }
+    RunSearch(workspace_, timing_, from, NO_INDEX);
+    std::vector<std::optional<Journey>> journeys;
+    journeys.reserve(targets.size());
+    for (const uint32_t to : targets) {
+        journeys.push_back(BuildJourney(timing_, to));
+    }
+    return journeys;
+}
+
+std::vector<std::pair<uint32_t, double>> RaptorRouter::BuildReachable(uint32_t from, double max_weight) const {
+    CheckStop(from);
+    std::vector<std::pair<uint32_t, double>> reachable;
+    if (max_weight < 0.0) {
+        return reachable;
+    }
+    RunSearch(workspace_, timing_, from, NO_INDEX, max_weight);
+    for (uint32_t stop = 0; stop < stop_count_; ++stop) {
+        if (workspace_.best_weights[stop] != INFINITE_WEIGHT) {
+            reachable.emplace_back(stop, workspace_.best_weights[stop]);
+        }
+    }
+    return reachable;
+}
+
+std::vector<double> RaptorRouter::BuildWeights(const std::vector<uint32_t>& origins, const std::vector<uint32_t>& targets) const {
+    for (const uint32_t from : origins) {
+        CheckStop(from);
+    }
+    for (const uint32_t to : targets) {
+        CheckStop(to);
+    }
+    std::vector<double> weights(origins.size() * targets.size(), INFINITE_WEIGHT);
+    parallel::ThreadPool thread_pool;
+    const size_t chunk_count = std::min(origins.size(), thread_pool.GetThreadCount());
+    thread_pool.ParallelFor(chunk_count, [&](size_t chunk) {
+        Workspace ws(stop_count_, patterns_.size());
+        for (size_t row = chunk; row < origins.size(); row += chunk_count) {
+            RunSearch(ws, timing_, origins[row], NO_INDEX);
+            for (size_t column = 0; column < targets.size(); ++column) {
+                weights[row * targets.size() + column] = ws.best_weights[targets[column]];
+            }
+        }
+    });
+    return weights;
+}
+
+double RaptorRouter::GetBusWaitTime() const {
+    return timing_.bus_wait_time;
+}
+
+double RaptorRouter::GetRideTime(const Timing& timing, const RoutePattern& pattern, uint32_t board_index, uint32_t alight_index) {
+    return static_cast<double>(pattern.distances[alight_index] - pattern.distances[board_index]) / timing.bus_speed;
+}
+
+// Если target != NO_INDEX, прибытия не лучше уже найденного до target отбрасываются.
+// Прибытия позже max_weight отбрасываются всегда
+void RaptorRouter::RunSearch(Workspace& ws, const Timing& timing, uint32_t from, uint32_t target, double max_weight) const {
+    std::fill(ws.best_weights.begin(), ws.best_weights.end(), INFINITE_WEIGHT);
+    ws.rounds.assign(1, std::vector<Label>(stop_count_));
+    ws.best_weights[from] = 0.0;
+    ws.rounds[0][from].weight = 0.0;
+    ws.marked_stops.assign(1, from);
+
+    while (!ws.marked_stops.empty()) {
+        for (const uint32_t stop : ws.marked_stops) {
+            ws.is_marked[stop] = false;
+            for (const auto& [pattern_id, index] : stop_patterns_[stop]) {
+                if (ws.pattern_starts[pattern_id] == NO_INDEX) {
+                    ws.queued_patterns.push_back(pattern_id);
+                    ws.pattern_starts[pattern_id] = index;
+                }
+                else {
+                    ws.pattern_starts[pattern_id] = std::min(ws.pattern_starts[pattern_id], index);
+                }
+            }
+        }
+        ws.marked_stops.clear();
+
+        const uint32_t round = static_cast<uint32_t>(ws.rounds.size());
+        ws.rounds.push_back(ws.rounds.back());
+        const std::vector<Label>& previous = ws.rounds[round - 1];
+        std::vector<Label>& current = ws.rounds[round];
+        for (const uint32_t pattern_id : ws.queued_patterns) {
+            const RoutePattern& pattern = patterns_[pattern_id];
+            uint32_t board_index = NO_INDEX;
+            double board_weight = INFINITE_WEIGHT;
+            for (uint32_t index = ws.pattern_starts[pattern_id]; index < pattern.stops.size(); ++index) {
+                const uint32_t stop = pattern.stops[index];
+                if (board_index != NO_INDEX) {
+                    const double weight = board_weight + GetRideTime(timing, pattern, board_index, index);
+                    const double bound = target == NO_INDEX ? INFINITE_WEIGHT : ws.best_weights[target];
+                    if (weight < ws.best_weights[stop] && weight < bound && weight <= max_weight) {
+                        ws.best_weights[stop] = weight;
+                        current[stop] = { weight, pattern_id, board_index, index, round };
+                        if (!ws.is_marked[stop]) {
+                            ws.is_marked[stop] = true;
+                            ws.marked_stops.push_back(stop);
+                        }
+                    }
+                }
+                // Пересесть на этот же автобус здесь выгоднее, чем ехать с прежней остановки посадки
+                const double stop_board_weight = previous[stop].weight + timing.bus_wait_time;
+                if (previous[stop].weight != INFINITE_WEIGHT
+                    && (board_index == NO_INDEX || stop_board_weight < board_weight + GetRideTime(timing, pattern, board_index, index))) {
+                    board_index = index;
+                    board_weight = stop_board_weight;
+                }
+            }
+            ws.pattern_starts[pattern_id] = NO_INDEX;
+        }
+        ws.queued_patterns.clear();
+    }
+}
+
+std::optional<RaptorRouter::Journey> RaptorRouter::BuildJourney(const Timing& timing, uint32_t to) const {
+    const Workspace& ws = workspace_;
+    if (ws.best_weights[to] == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    std::vector<Leg> legs;
+    const Label* label = &ws.rounds.back()[to];
+    while (label->pattern != NO_INDEX) {
+        const RoutePattern& pattern = patterns_[label->pattern];
+        const uint32_t board_stop = pattern.stops[label->board_index];
+        legs.push_back({ pattern.bus_id,
+                         board_stop,
+                         pattern.stops[label->alight_index],
+                         label->alight_index - label->board_index,
+                         GetRideTime(timing, pattern, label->board_index, label->alight_index) });
+        label = &ws.rounds[label->round - 1][board_stop];
+    }
+    std::reverse(legs.begin(), legs.end());
+
+    return Journey{ ws.best_weights[to], std::move(legs) };
+}
+
+void RaptorRouter::CheckStop(uint32_t stop) const {
+    if (stop >= stop_count_) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+}
+
+} // namespace transport
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+// Маршрут автобуса в одном направлении: номера остановок по порядку и
+// расстояния от первой остановки маршрута до каждой из них
+struct RoutePattern {
+    uint32_t bus_id;
+    std::vector<uint32_t> stops;
+    std::vector<int64_t> distances;
+};
+
+// Поиск маршрутов по раундам (RAPTOR) прямо по последовательностям остановок автобусов,
+// без квадратичного набора рёбер поездок. Раунд k находит лучшее время прибытия
+// не более чем с k поездками: каждый маршрут, проходящий через улучшенную
+// в прошлом раунде остановку, просматривается один раз за раунд.
+// Посадка стоит bus_wait_time, поездка - расстояние, делённое на скорость
+class RaptorRouter {
+public:
+    // Поездка на автобусе bus_id от остановки board_stop до alight_stop
+    struct Leg {
+        uint32_t bus_id;
+        uint32_t board_stop;
+        uint32_t alight_stop;
+        uint32_t span_count;
+        double ride_time;
+    };
+
+    struct Journey {
+        double weight;
+        std::vector<Leg> legs;
+    };
+
+    RaptorRouter(size_t stop_count, std::vector<RoutePattern> patterns, double bus_wait_time, double bus_velocity);
+
+    // Не потокобезопасен: все запросы используют общее рабочее пространство
+    std::optional<Journey> BuildRoute(uint32_t from, uint32_t to) const;
+    // Поиск с другими временем ожидания и скоростью вместо заданных в конструкторе
+    std::optional<Journey> BuildRoute(uint32_t from, uint32_t to, double bus_wait_time, double bus_velocity) const;
+    std::vector<std::optional<Journey>> BuildRoutes(uint32_t from, const std::vector<uint32_t>& targets) const;
+    // Все остановки, достижимые из from не дольше чем за max_weight, с временем прибытия
+    std::vector<std::pair<uint32_t, double>> BuildReachable(uint32_t from, double max_weight) const;
+    // Времена поездок из каждой origins в каждую targets построчно, бесконечность - маршрута нет.
+    // Поиски из разных origins идут параллельно, у каждого потока своё рабочее пространство
+    std::vector<double> BuildWeights(const std::vector<uint32_t>& origins, const std::vector<uint32_t>& targets) const;
+    double GetBusWaitTime() const;
+
+private:
+    static constexpr double INFINITE_WEIGHT = std::numeric_limits<double>::infinity();
+    static constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+    // Лучшее прибытие на остановку в раунде round и поездка, которой оно достигнуто.
+    // pattern == NO_INDEX у остановки отправления и у ещё не достигнутых остановок
+    struct Label {
+        double weight = INFINITE_WEIGHT;
+        uint32_t pattern = NO_INDEX;
+        uint32_t board_index = 0;
+        uint32_t alight_index = 0;
+        uint32_t round = 0;
+    };
+
+    // Время посадки и скорость в единицах расстояния за единицу времени
+    struct Timing {
+        double bus_wait_time;
+        double bus_speed;
+    };
+
+    struct Workspace {
+        std::vector<double> best_weights;
+        std::vector<std::vector<Label>> rounds;
+        std::vector<bool> is_marked;
+        std::vector<uint32_t> marked_stops;
+        // Самая ранняя отмеченная остановка маршрута, с которой его нужно просмотреть
+        std::vector<uint32_t> pattern_starts;
+        std::vector<uint32_t> queued_patterns;
+
+        Workspace(size_t stop_count, size_t pattern_count)
+            : best_weights(stop_count)
+            , is_marked(stop_count, false)
+            , pattern_starts(pattern_count, NO_INDEX) {
+        }
+    };
+
+    size_t stop_count_;
+    std::vector<RoutePattern> patterns_;
+    // Для каждой остановки - маршруты через неё и её номер в маршруте
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> stop_patterns_;
+    Timing timing_;
+    mutable Workspace workspace_;
+
+    static double GetRideTime(const Timing& timing, const RoutePattern& pattern, uint32_t board_index, uint32_t alight_index);
+    void RunSearch(Workspace& ws, const Timing& timing, uint32_t from, uint32_t target, double max_weight = INFINITE_WEIGHT) const;
+    std::optional<Journey> BuildJourney(const Timing& timing, uint32_t to) const;
+    void CheckStop(uint32_t stop) const;
+};
+
+} // namespace transport
\ No newline at end of file
@@ -1,36 +1,10 @@
 #include "request_handler.h"
 
 std::optional<transport::BusStat> RequestHandler::GetBusStat(const std::string_view bus_number) const {
-    transport::BusStat bus_stat{};
     const transport::Bus* bus = catalogue_.FindRoute(bus_number);
 
     if (!bus) throw std::invalid_argument("bus not found");
-    if (bus->is_circle) bus_stat.stops_count = bus->stops.size();
-    else bus_stat.stops_count = bus->stops.size() * 2 - 1;
-
-    int route_length = 0;
-    double geographic_length = 0.0;
-
-    for (size_t i = 0; i < bus->stops.size() - 1; ++i) {
-        auto from = bus->stops[i];
-        auto to = bus->stops[i + 1];
-        if (bus->is_circle) {
-            route_length += catalogue_.GetDistance(from, to);
-            geographic_length += geo::ComputeDistance(from->coordinates,
-                to->coordinates);
-        }
-        else {
-            route_length += catalogue_.GetDistance(from, to) + catalogue_.GetDistance(to, from);
-            geographic_length += geo::ComputeDistance(from->coordinates,
-                to->coordinates) * 2;
-        }
-    }
-
-    bus_stat.unique_stops_count = catalogue_.UniqueStopsCount(bus_number);
-    bus_stat.route_length = route_length;
-    bus_stat.curvature = route_length / geographic_length;
-
-    return bus_stat;
+    return catalogue_.GetBusStat(bus);
 }
 
 const std::set<std::string> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
@@ -45,14 +19,107 @@ bool RequestHandler::IsStopName(const std::string_view stop_name) const {
     return catalogue_.FindStop(stop_name);
 }
 
-const std::optional<graph::Router<double>::RouteInfo> RequestHandler::GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-    return router_.FindRoute(stop_from, stop_to);
+const std::optional<transport::RouteInfo> RequestHandler::GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const {
+    if (route_cache_.GetCapacity() == 0) {
+        return router_.FindRoute(GetStopVertex(stop_from), GetStopVertex(stop_to));
+    }
+    const std::pair<graph::VertexId, graph::VertexId> route_key{ GetStopVertex(stop_from), GetStopVertex(stop_to) };
+    if (auto cached_route = route_cache_.Find(route_key)) {
+        return std::move(*cached_route);
+    }
+    auto route = router_.FindRoute(route_key.first, route_key.second);
+    route_cache_.Put(route_key, route);
+    return route;
+}
+
+const std::optional<transport::RouteInfo> RequestHandler::GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to,
+    const transport::RoutingOverrides& overrides) const {
+    if (!overrides.bus_wait_time && !overrides.bus_velocity) {
+        return GetOptimalRoute(stop_from, stop_to);
+    }
+    return router_.FindRoute(GetStopVertex(stop_from), GetStopVertex(stop_to), overrides);
+}
+
+std::vector<std::optional<transport::RouteInfo>> RequestHandler::GetOptimalRoutes(const std::string_view stop_from,
+    const std::vector<std::string_view>& stops_to) const {
+    const graph::VertexId from = GetStopVertex(stop_from);
+    std::vector<graph::VertexId> targets;
+    targets.reserve(stops_to.size());
+    for (const std::string_view stop_to : stops_to) {
+        targets.push_back(GetStopVertex(stop_to));
+    }
+    if (route_cache_.GetCapacity() == 0) {
+        return router_.FindRoutes(from, targets);
+    }
+
+    std::vector<std::optional<transport::RouteInfo>> routes(targets.size());
+    std::vector<size_t> missed_positions;
+    std::vector<graph::VertexId> missed_targets;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (auto cached_route = route_cache_.Find({ from, targets[i] })) {
+            routes[i] = std::move(*cached_route);
+        }
+        else {
+            missed_positions.push_back(i);
+            missed_targets.push_back(targets[i]);
+        }
+    }
+    if (missed_targets.empty()) {
+        return routes;
+    }
+    auto found_routes = router_.FindRoutes(from, missed_targets);
+    for (size_t i = 0; i < missed_positions.size(); ++i) {
+        route_cache_.Put({ from, missed_targets[i] }, found_routes[i]);
+        routes[missed_positions[i]] = std::move(found_routes[i]);
+    }
+    return routes;
+}
+
+std::vector<double> RequestHandler::GetTravelTimes(const std::vector<std::string_view>& stops_from,
+    const std::vector<std::string_view>& stops_to) const {
+    const auto to_vertices = [this](const std::vector<std::string_view>& stops) {
+        std::vector<graph::VertexId> vertices;
+        vertices.reserve(stops.size());
+        for (const std::string_view stop : stops) {
+            vertices.push_back(GetStopVertex(stop));
+        }
+        return vertices;
+    };
+    return router_.FindTravelTimes(to_vertices(stops_from), to_vertices(stops_to));
+}
+
+std::vector<std::pair<const transport::Stop*, double>> RequestHandler::GetReachableStops(const std::string_view stop_from, double max_time) const {
+    return router_.FindReachableStops(GetStop(stop_from)->id, max_time);
 }
 
 const graph::DirectedWeightedGraph<double>& RequestHandler::GetRouterGraph() const {
     return router_.GetGraph();
 }
 
+std::string_view RequestHandler::GetEdgeName(const graph::Edge<double>& edge) const {
+    return router_.GetEdgeName(edge);
+}
+
+size_t RequestHandler::GetRouteCacheHits() const {
+    return route_cache_.GetHitCount();
+}
+
+size_t RequestHandler::GetRouteCacheMisses() const {
+    return route_cache_.GetMissCount();
+}
+
 svg::Document RequestHandler::RenderMap() const {
-    return renderer_.GetSVG(catalogue_.GetSortedAllBuses());
+    return renderer_.GetSVG(catalogue_.GetSortedAllBuses(), catalogue_.GetSortedAllStops());
+}
+
+const transport::Stop* RequestHandler::GetStop(const std::string_view stop_name) const {
+    const transport::Stop* stop = catalogue_.FindStop(stop_name);
+    if (!stop) {
+        throw std::out_of_range("Unknown stop " + std::string(stop_name));
+    }
+    return stop;
+}
+
+graph::VertexId RequestHandler::GetStopVertex(const std::string_view stop_name) const {
+    return router_.GetStopVertex(GetStop(stop_name)->id);
 }
\ No newline at end of file
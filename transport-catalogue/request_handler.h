@@ -4,7 +4,9 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "lru_cache.h"
 
+#include <cstdint>
 #include <sstream>
 #include <optional>
 
@@ -14,6 +16,7 @@ public:
         : catalogue_(catalogue)
         , renderer_(renderer)
         , router_(router)
+        , route_cache_(router.GetRoutingSettings().route_cache_size)
     {
     }
 
@@ -21,13 +24,42 @@ public:
     const std::set<std::string> GetBusesByStop(std::string_view stop_name) const;
     bool IsBusNumber(const std::string_view bus_number) const;
     bool IsStopName(const std::string_view stop_name) const;
-    const std::optional<graph::Router<double>::RouteInfo> GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    const std::optional<transport::RouteInfo> GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    // Маршрут с переопределёнными параметрами движения; такие маршруты не кэшируются
+    const std::optional<transport::RouteInfo> GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to,
+        const transport::RoutingOverrides& overrides) const;
+    // Маршруты из stop_from во все stops_to; промахи кэша считаются одним пакетом
+    std::vector<std::optional<transport::RouteInfo>> GetOptimalRoutes(const std::string_view stop_from, const std::vector<std::string_view>& stops_to) const;
+    // Матрица времён поездок построчно по stops_from, бесконечность - маршрута нет. Кэш маршрутов не используется
+    std::vector<double> GetTravelTimes(const std::vector<std::string_view>& stops_from, const std::vector<std::string_view>& stops_to) const;
+    std::vector<std::pair<const transport::Stop*, double>> GetReachableStops(const std::string_view stop_from, double max_time) const;
     const graph::DirectedWeightedGraph<double>& GetRouterGraph() const;
+    std::string_view GetEdgeName(const graph::Edge<double>& edge) const;
+    size_t GetRouteCacheHits() const;
+    size_t GetRouteCacheMisses() const;
 
     svg::Document RenderMap() const;
 
 private:
+    struct RouteKeyHasher {
+        // Ключи - вершины остановок (всегда чётные), поэтому пара упаковывается в 64 бита
+        // и перемешивается финализатором splitmix64, чтобы задействовать все биты хеша
+        size_t operator()(const std::pair<graph::VertexId, graph::VertexId>& route_key) const {
+            uint64_t hash = (static_cast<uint64_t>(route_key.first) << 32) | static_cast<uint32_t>(route_key.second);
+            hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+            hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+            return static_cast<size_t>(hash ^ (hash >> 31));
+        }
+    };
+    using RouteCache = cache::LruCache<std::pair<graph::VertexId, graph::VertexId>,
+                                       std::optional<transport::RouteInfo>, RouteKeyHasher>;
+
+    // Названия из запросов переводятся в id остановок здесь, маршрутизатор работает с id
+    const transport::Stop* GetStop(const std::string_view stop_name) const;
+    graph::VertexId GetStopVertex(const std::string_view stop_name) const;
+
     const transport::Catalogue& catalogue_;
     const renderer::MapRenderer& renderer_;
     const transport::Router& router_;
+    mutable RouteCache route_cache_;
 };
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
 
 #include "graph.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -15,103 +19,564 @@
 namespace graph {
 
 template <typename Weight>
+struct RouteInfo {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+// Способ хранения ячейки таблицы маршрутов: тип веса и тип id последнего ребра
+template <typename Weight>
+struct ExactRoutesStorage {
+    using StoredWeight = Weight;
+    using StoredEdgeId = EdgeId;
+};
+
+// 8 байт на ячейку вместо 16 у ExactRoutesStorage<double>: вес во float, id ребра в 32 битах.
+// Маршрут выбирается по суммам во float, поэтому его вес может превышать оптимальный
+// примерно на 2^-24 от веса на каждое ребро пути. Вес найденного маршрута
+// пересчитывается по весам рёбер графа
+struct CompactRoutesStorage {
+    using StoredWeight = float;
+    using StoredEdgeId = uint32_t;
+};
+
+// Стоимость восстановления таблицы маршрутов после изменения графа
+struct RoutesRepairStats {
+    // Строки, посчитанные заново целиком
+    size_t rebuilt_row_count = 0;
+    // Строки, в которых распространялись улучшения от изменённых рёбер
+    size_t repaired_row_count = 0;
+    // Вершины, извлечённые из кучи во всех строках
+    size_t settled_vertex_count = 0;
+};
+
+template <typename Weight, typename Storage = ExactRoutesStorage<Weight>>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
+    using StoredWeight = typename Storage::StoredWeight;
+    using StoredEdgeId = typename Storage::StoredEdgeId;
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Router requires a weight type with infinity");
+    static_assert(std::numeric_limits<StoredWeight>::has_infinity, "Router requires a stored weight type with infinity");
 
 public:
+    // Маршруты существуют только внутри компонент слабой связности графа, поэтому
+    // для каждой компоненты из n вершин хранится своя таблица n x n в локальной нумерации.
+    // Вершины компоненты c - отрезок [component_offsets[c], component_offsets[c + 1])
+    // массива component_vertices, таблицы компонент лежат подряд в weights и prev_edges.
+    // Вес INFINITE_STORED_WEIGHT означает отсутствие маршрута, NO_STORED_EDGE - маршрут без рёбер
+    struct RoutesInternalData {
+        size_t vertex_count = 0;
+        std::vector<VertexId> component_vertices;
+        std::vector<size_t> component_offsets;
+        std::vector<StoredWeight> weights;
+        std::vector<StoredEdgeId> prev_edges;
+    };
+
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    static constexpr StoredWeight INFINITE_STORED_WEIGHT = std::numeric_limits<StoredWeight>::infinity();
+    static constexpr StoredEdgeId NO_STORED_EDGE = std::numeric_limits<StoredEdgeId>::max();
+
     explicit Router(const Graph& graph);
+    // Принимает заранее рассчитанные маршруты (например, загруженные из базы) без повторного расчёта
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
-    };
+    using RouteInfo = graph::RouteInfo<Weight>;
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Веса маршрутов из каждой origins в каждую targets построчно, INFINITE_WEIGHT - маршрута нет
+    std::vector<Weight> BuildWeights(const std::vector<VertexId>& origins, const std::vector<VertexId>& targets) const;
+    // Восстанавливает таблицу после UpdateEdges графа без полного пересчёта
+    RoutesRepairStats UpdateRoutes(const EdgesUpdate& update);
+    // Восстанавливает таблицу после UpdateEdgeWeights графа: строки, чьи кратчайшие пути
+    // проходят через подорожавшее ребро, считаются заново, в остальных распространяются
+    // только улучшения через подешевевшие рёбра
+    RoutesRepairStats UpdateWeights(const WeightsUpdate& update);
+    const RoutesInternalData& GetRoutesInternalData() const;
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    // Сторона квадратного блока таблицы, который релаксируется целиком
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    // Таблица одной компоненты: начало в weights и prev_edges и число вершин
+    struct ComponentTable {
+        size_t offset;
+        size_t size;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
-    void InitializeRoutesInternalData(const Graph& graph) {
+    void CheckEdgeCount(const Graph& graph) const {
+        if (graph.GetEdgeCount() >= static_cast<size_t>(NO_STORED_EDGE)) {
+            throw std::length_error("Too many edges for the routes storage");
+        }
+    }
+
+    // Разбивает вершины на компоненты слабой связности системой непересекающихся множеств.
+    // Компоненты нумеруются в порядке их наименьших вершин
+    void SplitComponents(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        std::vector<VertexId> parents(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            parents[vertex] = vertex;
+        }
+        const auto find_root = [&parents](VertexId vertex) {
+            while (parents[vertex] != vertex) {
+                parents[vertex] = parents[parents[vertex]];
+                vertex = parents[vertex];
+            }
+            return vertex;
+        };
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            const VertexId from_root = find_root(edge.from);
+            const VertexId to_root = find_root(edge.to);
+            parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+        }
+
+        std::vector<size_t> root_components(vertex_count, NO_COMPONENT);
+        std::vector<size_t> component_sizes;
+        std::vector<size_t> vertex_components(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const VertexId root = find_root(vertex);
+            if (root_components[root] == NO_COMPONENT) {
+                root_components[root] = component_sizes.size();
+                component_sizes.push_back(0);
+            }
+            vertex_components[vertex] = root_components[root];
+            ++component_sizes[vertex_components[vertex]];
+        }
+
+        auto& offsets = routes_internal_data_.component_offsets;
+        offsets.assign(component_sizes.size() + 1, 0);
+        for (size_t component = 0; component < component_sizes.size(); ++component) {
+            offsets[component + 1] = offsets[component] + component_sizes[component];
+        }
+        auto& vertices = routes_internal_data_.component_vertices;
+        vertices.resize(vertex_count);
+        std::vector<size_t> positions(offsets.begin(), offsets.end() - 1);
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+            vertices[positions[vertex_components[vertex]]++] = vertex;
+        }
+    }
+
+    // Восстанавливает номера компонент, локальные номера вершин и положение таблиц
+    // по component_vertices и component_offsets
+    void IndexComponents() {
+        const auto& offsets = routes_internal_data_.component_offsets;
+        const auto& vertices = routes_internal_data_.component_vertices;
+        const size_t vertex_count = routes_internal_data_.vertex_count;
+        if (offsets.empty() || offsets.front() != 0 || offsets.back() != vertex_count || vertices.size() != vertex_count) {
+            throw std::invalid_argument("Routes internal data doesn't match the graph");
+        }
+        component_ids_.assign(vertex_count, NO_COMPONENT);
+        local_ids_.assign(vertex_count, 0);
+        tables_.clear();
+        size_t table_offset = 0;
+        for (size_t component = 0; component + 1 < offsets.size(); ++component) {
+            if (offsets[component] > offsets[component + 1]) {
+                throw std::invalid_argument("Routes internal data doesn't match the graph");
+            }
+            const size_t size = offsets[component + 1] - offsets[component];
+            for (size_t local_id = 0; local_id < size; ++local_id) {
+                const VertexId vertex = vertices[offsets[component] + local_id];
+                if (vertex >= vertex_count || component_ids_[vertex] != NO_COMPONENT) {
+                    throw std::invalid_argument("Routes internal data doesn't match the graph");
+                }
+                component_ids_[vertex] = component;
+                local_ids_[vertex] = local_id;
+            }
+            tables_.push_back({ table_offset, size });
+            table_offset += size * size;
+        }
+        if (routes_internal_data_.weights.size() != table_offset || routes_internal_data_.prev_edges.size() != table_offset) {
+            throw std::invalid_argument("Routes internal data doesn't match the graph");
+        }
+    }
+
+    void InitializeRoutesInternalData(const Graph& graph) {
+        auto& weights = routes_internal_data_.weights;
+        auto& prev_edges = routes_internal_data_.prev_edges;
+        for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            const ComponentTable& table = tables_[component_ids_[vertex]];
+            const size_t row = table.offset + local_ids_[vertex] * table.size;
+            weights[row + local_ids_[vertex]] = ZERO_STORED_WEIGHT;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                const size_t cell = row + local_ids_[edge.to];
+                const StoredWeight weight = static_cast<StoredWeight>(edge.weight);
+                if (weights[cell] > weight) {
+                    weights[cell] = weight;
+                    prev_edges[cell] = static_cast<StoredEdgeId>(edge_id);
+                }
+            }
+        }
+    }
+
+    // Релаксирует блок (block_from, block_to) таблицы компоненты через вершины блока block_through.
+    // Внутренний цикл без ветвлений, чтобы компилятор мог его векторизовать
+    void RelaxBlock(const ComponentTable& table, size_t block_from, size_t block_to, size_t block_through) {
+        const size_t vertex_count = table.size;
+        StoredWeight* const weights = routes_internal_data_.weights.data() + table.offset;
+        StoredEdgeId* const prev_edges = routes_internal_data_.prev_edges.data() + table.offset;
+        const VertexId from_end = std::min(vertex_count, (block_from + 1) * BLOCK_SIZE);
+        const VertexId to_begin = block_to * BLOCK_SIZE;
+        const VertexId to_end = std::min(vertex_count, to_begin + BLOCK_SIZE);
+        const VertexId through_end = std::min(vertex_count, (block_through + 1) * BLOCK_SIZE);
+
+        for (VertexId vertex_through = block_through * BLOCK_SIZE; vertex_through < through_end; ++vertex_through) {
+            const StoredWeight* const weights_through = weights + vertex_through * vertex_count;
+            const StoredEdgeId* const prev_edges_through = prev_edges + vertex_through * vertex_count;
+            for (VertexId vertex_from = block_from * BLOCK_SIZE; vertex_from < from_end; ++vertex_from) {
+                StoredWeight* const weights_from = weights + vertex_from * vertex_count;
+                StoredEdgeId* const prev_edges_from = prev_edges + vertex_from * vertex_count;
+                const StoredWeight weight_from = weights_from[vertex_through];
+                if (weight_from == INFINITE_STORED_WEIGHT) {
+                    continue;
+                }
+                for (VertexId vertex_to = to_begin; vertex_to < to_end; ++vertex_to) {
+                    const StoredWeight candidate_weight = weight_from + weights_through[vertex_to];
+                    const bool is_better = candidate_weight < weights_from[vertex_to];
+                    weights_from[vertex_to] = is_better ? candidate_weight : weights_from[vertex_to];
+                    prev_edges_from[vertex_to] = is_better ? prev_edges_through[vertex_to] : prev_edges_from[vertex_to];
+                }
+            }
+        }
+    }
+
+    // Блочный алгоритм Флойда-Уоршелла для таблицы одной компоненты. На каждой фазе сначала
+    // релаксируется диагональный блок, затем блоки его строки и столбца, затем все остальные.
+    // Блоки второго и третьего этапов независимы друг от друга и обрабатываются параллельно
+    void RelaxComponent(parallel::ThreadPool& thread_pool, const ComponentTable& table) {
+        const size_t block_count = (table.size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const size_t other_count = block_count > 0 ? block_count - 1 : 0;
+        for (size_t block_through = 0; block_through < block_count; ++block_through) {
+            const auto skip_through = [block_through](size_t block) {
+                return block >= block_through ? block + 1 : block;
+            };
+
+            RelaxBlock(table, block_through, block_through, block_through);
+
+            thread_pool.ParallelFor(2 * other_count, [&](size_t index) {
+                const size_t block = skip_through(index / 2);
+                if (index % 2 == 0) {
+                    RelaxBlock(table, block_through, block, block_through);
+                }
+                else {
+                    RelaxBlock(table, block, block_through, block_through);
                 }
+            });
+
+            thread_pool.ParallelFor(other_count * other_count, [&](size_t index) {
+                RelaxBlock(table, skip_through(index / other_count), skip_through(index % other_count), block_through);
+            });
+        }
+    }
+
+    // Компоненты не больше одного блока считаются целиком параллельно друг с другом,
+    // у больших компонент параллелятся блоки внутри фазы
+    void RelaxRoutesInternalData() {
+        parallel::ThreadPool thread_pool;
+        std::vector<size_t> small_components;
+        for (size_t component = 0; component < tables_.size(); ++component) {
+            if (tables_[component].size <= BLOCK_SIZE) {
+                small_components.push_back(component);
+            }
+            else {
+                RelaxComponent(thread_pool, tables_[component]);
             }
         }
+        thread_pool.ParallelFor(small_components.size(), [&](size_t index) {
+            const ComponentTable& table = tables_[small_components[index]];
+            if (table.size > 0) {
+                RelaxBlock(table, 0, 0, 0);
+            }
+        });
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-        const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = { candidate_weight,
-                                route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+    void BuildRoutesInternalData(const Graph& graph) {
+        routes_internal_data_.vertex_count = graph.GetVertexCount();
+        SplitComponents(graph);
+        size_t cell_count = 0;
+        const auto& offsets = routes_internal_data_.component_offsets;
+        for (size_t component = 0; component + 1 < offsets.size(); ++component) {
+            const size_t size = offsets[component + 1] - offsets[component];
+            cell_count += size * size;
         }
+        routes_internal_data_.weights.clear();
+        routes_internal_data_.prev_edges.clear();
+        routes_internal_data_.weights.assign(cell_count, INFINITE_STORED_WEIGHT);
+        routes_internal_data_.prev_edges.assign(cell_count, NO_STORED_EDGE);
+        IndexComponents();
+        InitializeRoutesInternalData(graph);
+        RelaxRoutesInternalData();
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    // Вес маршрута без построения списка рёбер. Для хранения с округлением
+    // он пересчитывается по весам рёбер графа, как в BuildRoute
+    Weight GetRouteWeight(VertexId from, VertexId to) const {
+        const size_t vertex_count = routes_internal_data_.vertex_count;
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (component_ids_[from] != component_ids_[to]) {
+            return INFINITE_WEIGHT;
+        }
+        const ComponentTable& table = tables_[component_ids_[from]];
+        const size_t row = table.offset + local_ids_[from] * table.size;
+        const StoredWeight stored_weight = routes_internal_data_.weights[row + local_ids_[to]];
+        if (stored_weight == INFINITE_STORED_WEIGHT) {
+            return INFINITE_WEIGHT;
+        }
+        if constexpr (std::is_same_v<StoredWeight, Weight>) {
+            return stored_weight;
+        }
+        else {
+            const StoredEdgeId* const prev_edges_from = routes_internal_data_.prev_edges.data() + row;
+            Weight weight = ZERO_WEIGHT;
+            for (StoredEdgeId edge_id = prev_edges_from[local_ids_[to]];
+                edge_id != NO_STORED_EDGE;
+                edge_id = prev_edges_from[local_ids_[graph_.GetEdge(edge_id).from]])
+            {
+                weight += graph_.GetEdge(edge_id).weight;
+            }
+            return weight;
+        }
+    }
+
+    // Строка from использует ребро e тогда и только тогда, когда prev_edges[from][e.to] == e.
+    // Строка с удалённым ребром пересчитывается целиком. В остальных строках расстояния
+    // могут только уменьшиться, и восстанавливаются от добавленных рёбер.
+    // Рёбра не выходят за пределы компоненты from: объединение компонент обрабатывает UpdateRoutes
+    RoutesRepairStats UpdateRow(VertexId from, const EdgesUpdate& update) {
+        const ComponentTable& table = tables_[component_ids_[from]];
+        const size_t row = table.offset + local_ids_[from] * table.size;
+        StoredEdgeId* const prev_edges_from = routes_internal_data_.prev_edges.data() + row;
+        bool uses_removed_edge = false;
+        for (size_t to = 0; to < table.size; ++to) {
+            if (prev_edges_from[to] != NO_STORED_EDGE) {
+                const EdgeId edge_id = update.old_edge_ids[prev_edges_from[to]];
+                prev_edges_from[to] = edge_id == EdgesUpdate::NO_EDGE ? NO_STORED_EDGE : static_cast<StoredEdgeId>(edge_id);
+                uses_removed_edge = uses_removed_edge || edge_id == EdgesUpdate::NO_EDGE;
+            }
+        }
+        return RepairRow(from, uses_removed_edge, update.added_edge_ids);
+    }
+
+    // То же для изменения весов: подорожавшее ребро играет роль удалённого, подешевевшее - добавленного
+    RoutesRepairStats UpdateWeightsRow(VertexId from, const WeightsUpdate& update) {
+        const ComponentTable& table = tables_[component_ids_[from]];
+        const StoredEdgeId* const prev_edges_from = routes_internal_data_.prev_edges.data() + table.offset + local_ids_[from] * table.size;
+        const bool uses_increased_edge = std::any_of(update.increased_edge_ids.begin(), update.increased_edge_ids.end(),
+            [this, from, prev_edges_from](EdgeId edge_id) {
+                const VertexId to = graph_.GetEdge(edge_id).to;
+                return component_ids_[to] == component_ids_[from] && prev_edges_from[local_ids_[to]] == static_cast<StoredEdgeId>(edge_id);
+            });
+        return RepairRow(from, uses_increased_edge, update.decreased_edge_ids);
+    }
+
+    // При rebuild строка from считается заново алгоритмом Дейкстры, иначе Дейкстра
+    // запускается только от улучшений через рёбра improving_edges
+    RoutesRepairStats RepairRow(VertexId from, bool rebuild, const std::vector<EdgeId>& improving_edges) {
+        const ComponentTable& table = tables_[component_ids_[from]];
+        const size_t row = table.offset + local_ids_[from] * table.size;
+        StoredWeight* const weights_from = routes_internal_data_.weights.data() + row;
+        StoredEdgeId* const prev_edges_from = routes_internal_data_.prev_edges.data() + row;
+        RoutesRepairStats stats;
+
+        std::vector<std::pair<StoredWeight, VertexId>> heap;
+        const auto reach = [&](VertexId vertex, StoredWeight weight, EdgeId prev_edge) {
+            weights_from[local_ids_[vertex]] = weight;
+            prev_edges_from[local_ids_[vertex]] = prev_edge == NO_EDGE ? NO_STORED_EDGE : static_cast<StoredEdgeId>(prev_edge);
+            heap.emplace_back(weight, vertex);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        };
+        if (rebuild) {
+            std::fill(weights_from, weights_from + table.size, INFINITE_STORED_WEIGHT);
+            std::fill(prev_edges_from, prev_edges_from + table.size, NO_STORED_EDGE);
+            reach(from, ZERO_STORED_WEIGHT, NO_EDGE);
+            stats.rebuilt_row_count = 1;
+        }
+        else {
+            for (const EdgeId edge_id : improving_edges) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (component_ids_[edge.from] != component_ids_[from]) {
+                    continue;
+                }
+                const StoredWeight weight = weights_from[local_ids_[edge.from]];
+                const StoredWeight candidate_weight = weight + static_cast<StoredWeight>(edge.weight);
+                if (weight != INFINITE_STORED_WEIGHT && candidate_weight < weights_from[local_ids_[edge.to]]) {
+                    reach(edge.to, candidate_weight, edge_id);
                 }
             }
+            stats.repaired_row_count = heap.empty() ? 0 : 1;
         }
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto [weight, vertex] = heap.back();
+            heap.pop_back();
+            if (weights_from[local_ids_[vertex]] < weight) {
+                continue;
+            }
+            ++stats.settled_vertex_count;
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const StoredWeight candidate_weight = weight + static_cast<StoredWeight>(edge.weight);
+                if (candidate_weight < weights_from[local_ids_[edge.to]]) {
+                    reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+        return stats;
     }
 
+    // Строки восстанавливаются независимо друг от друга
+    template <typename RowUpdate>
+    RoutesRepairStats RepairRows(RowUpdate row_update) {
+        std::vector<RoutesRepairStats> row_stats(routes_internal_data_.vertex_count);
+        parallel::ThreadPool thread_pool;
+        thread_pool.ParallelFor(routes_internal_data_.vertex_count, [&row_stats, &row_update](size_t from) {
+            row_stats[from] = row_update(from);
+        });
+        RoutesRepairStats stats;
+        for (const RoutesRepairStats& row : row_stats) {
+            stats.rebuilt_row_count += row.rebuilt_row_count;
+            stats.repaired_row_count += row.repaired_row_count;
+            stats.settled_vertex_count += row.settled_vertex_count;
+        }
+        return stats;
+    }
+
+    static constexpr size_t NO_COMPONENT = std::numeric_limits<size_t>::max();
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr StoredWeight ZERO_STORED_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
+    // Номер компоненты и номер внутри компоненты для каждой вершины, таблицы компонент
+    std::vector<size_t> component_ids_;
+    std::vector<size_t> local_ids_;
+    std::vector<ComponentTable> tables_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-        std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
-    InitializeRoutesInternalData(graph);
+    CheckEdgeCount(graph);
+    BuildRoutesInternalData(graph);
+}
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
+    CheckEdgeCount(graph);
+    if (routes_internal_data_.vertex_count != graph.GetVertexCount()) {
+        throw std::invalid_argument("Routes internal data doesn't match the graph");
     }
+    IndexComponents();
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
+template <typename Weight, typename Storage>
+std::optional<typename Router<Weight, Storage>::RouteInfo> Router<Weight, Storage>::BuildRoute(VertexId from,
     VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    const size_t vertex_count = routes_internal_data_.vertex_count;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (component_ids_[from] != component_ids_[to]) {
+        return std::nullopt;
+    }
+    const ComponentTable& table = tables_[component_ids_[from]];
+    const size_t row = table.offset + local_ids_[from] * table.size;
+    const StoredWeight* const weights_from = routes_internal_data_.weights.data() + row;
+    const StoredEdgeId* const prev_edges_from = routes_internal_data_.prev_edges.data() + row;
+    if (weights_from[local_ids_[to]] == INFINITE_STORED_WEIGHT) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-        edge_id;
-        edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (StoredEdgeId edge_id = prev_edges_from[local_ids_[to]];
+        edge_id != NO_STORED_EDGE;
+        edge_id = prev_edges_from[local_ids_[graph_.GetEdge(edge_id).from]])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{ weight, std::move(edges) };
+    if constexpr (std::is_same_v<StoredWeight, Weight>) {
+        return RouteInfo{ weights_from[local_ids_[to]], std::move(edges) };
+    }
+    else {
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return RouteInfo{ weight, std::move(edges) };
+    }
+}
+
+template <typename Weight, typename Storage>
+std::vector<Weight> Router<Weight, Storage>::BuildWeights(const std::vector<VertexId>& origins,
+    const std::vector<VertexId>& targets) const {
+    std::vector<Weight> weights;
+    weights.reserve(origins.size() * targets.size());
+    for (const VertexId from : origins) {
+        for (const VertexId to : targets) {
+            weights.push_back(GetRouteWeight(from, to));
+        }
+    }
+    return weights;
+}
+
+// Удаление рёбер может разбить компоненту, но прежняя компонента остаётся верной (часть её
+// ячеек просто недостижима). Добавленное ребро между компонентами объединяет их,
+// и тогда таблицы строятся заново, а все строки считаются пересчитанными
+template <typename Weight, typename Storage>
+RoutesRepairStats Router<Weight, Storage>::UpdateRoutes(const EdgesUpdate& update) {
+    if (graph_.GetVertexCount() != routes_internal_data_.vertex_count) {
+        throw std::invalid_argument("Routes internal data doesn't match the graph");
+    }
+    CheckEdgeCount(graph_);
+    bool merges_components = false;
+    for (const EdgeId edge_id : update.added_edge_ids) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        merges_components = merges_components || component_ids_[edge.from] != component_ids_[edge.to];
+    }
+    if (merges_components) {
+        BuildRoutesInternalData(graph_);
+        RoutesRepairStats stats;
+        stats.rebuilt_row_count = routes_internal_data_.vertex_count;
+        return stats;
+    }
+    return RepairRows([this, &update](VertexId from) {
+        return UpdateRow(from, update);
+    });
+}
+
+// Рёбра и вершины графа остаются прежними, поэтому компоненты не меняются
+template <typename Weight, typename Storage>
+RoutesRepairStats Router<Weight, Storage>::UpdateWeights(const WeightsUpdate& update) {
+    if (graph_.GetVertexCount() != routes_internal_data_.vertex_count) {
+        throw std::invalid_argument("Routes internal data doesn't match the graph");
+    }
+    if (update.increased_edge_ids.empty() && update.decreased_edge_ids.empty()) {
+        return {};
+    }
+    return RepairRows([this, &update](VertexId from) {
+        return UpdateWeightsRow(from, update);
+    });
+}
+
+template <typename Weight, typename Storage>
+const typename Router<Weight, Storage>::RoutesInternalData& Router<Weight, Storage>::GetRoutesInternalData() const {
+    return routes_internal_data_;
 }
 
 }  // namespace graph
\ No newline at end of file
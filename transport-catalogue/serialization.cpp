@@ -1,9 +1,77 @@
 #include "serialization.h"
 
 #include <fstream>
+#include <memory>
 
 namespace serialization {
 
+namespace {
+
+// Ячейки таблицы маршрутов при любом способе хранения: prev_edge кодируется одинаково,
+// а вес добавляется в поле, соответствующее типу веса
+template <typename RoutesRouter, typename AddWeight>
+void SerializeRoutesCells(const typename RoutesRouter::RoutesInternalData& routes_internal_data,
+    proto_transport::RoutesInternalData& proto_routes, AddWeight add_weight) {
+    for (const auto vertex : routes_internal_data.component_vertices) {
+        proto_routes.add_component_vertex(vertex);
+    }
+    for (const size_t offset : routes_internal_data.component_offsets) {
+        proto_routes.add_component_offset(offset);
+    }
+    const size_t cell_count = routes_internal_data.weights.size();
+    proto_routes.mutable_prev_edge()->Reserve(cell_count);
+    for (size_t cell = 0; cell < cell_count; ++cell) {
+        const auto weight = routes_internal_data.weights[cell];
+        const auto prev_edge = routes_internal_data.prev_edges[cell];
+        if (weight == RoutesRouter::INFINITE_STORED_WEIGHT) {
+            add_weight(0);
+            proto_routes.add_prev_edge(0);
+        }
+        else {
+            add_weight(weight);
+            proto_routes.add_prev_edge(prev_edge == RoutesRouter::NO_STORED_EDGE ? 1 : static_cast<uint64_t>(prev_edge) + 2);
+        }
+    }
+}
+
+template <typename RoutesRouter, typename ProtoWeights>
+typename RoutesRouter::RoutesInternalData DeserializeRoutesCells(const proto_transport::TransportCatalogue& proto_db, const ProtoWeights& proto_weights) {
+    const proto_transport::RoutesInternalData& proto_routes = proto_db.routes_internal_data();
+    const size_t vertex_count = proto_db.router().graph().offset_size() > 0 ? proto_db.router().graph().offset_size() - 1 : 0;
+    if (static_cast<size_t>(proto_routes.component_vertex_size()) != vertex_count
+        || proto_routes.component_offset_size() == 0) {
+        throw std::runtime_error("Error deserialized routes internal data");
+    }
+    size_t cell_count = 0;
+    for (int component = 0; component + 1 < proto_routes.component_offset_size(); ++component) {
+        if (proto_routes.component_offset(component) > proto_routes.component_offset(component + 1)) {
+            throw std::runtime_error("Error deserialized routes internal data");
+        }
+        const size_t size = proto_routes.component_offset(component + 1) - proto_routes.component_offset(component);
+        cell_count += size * size;
+    }
+    if (static_cast<size_t>(proto_routes.prev_edge_size()) != cell_count
+        || proto_weights.size() != proto_routes.prev_edge_size()) {
+        throw std::runtime_error("Error deserialized routes internal data");
+    }
+    using StoredWeight = typename decltype(RoutesRouter::RoutesInternalData::weights)::value_type;
+    using StoredEdgeId = typename decltype(RoutesRouter::RoutesInternalData::prev_edges)::value_type;
+    typename RoutesRouter::RoutesInternalData routes_internal_data{ vertex_count,
+        { proto_routes.component_vertex().begin(), proto_routes.component_vertex().end() },
+        { proto_routes.component_offset().begin(), proto_routes.component_offset().end() },
+        std::vector<StoredWeight>(cell_count, RoutesRouter::INFINITE_STORED_WEIGHT),
+        std::vector<StoredEdgeId>(cell_count, RoutesRouter::NO_STORED_EDGE) };
+    for (size_t cell = 0; cell < cell_count; ++cell) {
+        const uint64_t prev_edge = proto_routes.prev_edge(cell);
+        if (prev_edge == 0) continue;
+        routes_internal_data.weights[cell] = proto_weights.Get(cell);
+        if (prev_edge > 1) routes_internal_data.prev_edges[cell] = static_cast<StoredEdgeId>(prev_edge - 2);
+    }
+    return routes_internal_data;
+}
+
+} // namespace
+
 void Serialize(const transport::Catalogue& db, const renderer::MapRenderer& renderer, const transport::Router& router, std::ostream& out) {
     proto_transport::TransportCatalogue proto_db;
 
@@ -12,12 +80,14 @@ void Serialize(const transport::Catalogue& db, const renderer::MapRenderer& rend
     SerializeBuses(db, proto_db);
     SerializeRenderSettings(renderer, proto_db);
     SerializeRouter(router, proto_db);
+    SerializeRoutesInternalData(router, proto_db);
     
     proto_db.SerializeToOstream(&out);
 }
 
-std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router, graph::DirectedWeightedGraph<double>, std::map<std::string, graph::VertexId>> Deserialize(std::istream& input) {
-    proto_transport::TransportCatalogue proto_db;
+std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router, graph::DirectedWeightedGraph<double>, std::vector<graph::VertexId>, transport::RouterDataLoader> Deserialize(std::istream& input) {
+    const auto proto_db_ptr = std::make_shared<proto_transport::TransportCatalogue>();
+    proto_transport::TransportCatalogue& proto_db = *proto_db_ptr;
     proto_db.ParseFromIstream(&input);
 
     transport::Catalogue db;
@@ -30,17 +100,23 @@ std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router, graph
     renderer::MapRenderer renderer = DeserializeRenderSettings(render_settings, proto_db);
     transport::Router router = DeserializeRouterSettings(proto_db);
     
-    return { std::move(db), std::move(renderer), std::move(router), DeserializeGraph(proto_db), DeserializeStopIds(proto_db) };
+    // Таблица маршрутов и иерархия разбираются при сборке движка, разобранная база живёт до тех пор
+    transport::RouterDataLoader load_router_data = [proto_db_ptr]() {
+        return transport::RouterData{ DeserializeRoutesInternalData(*proto_db_ptr), DeserializeCompactRoutesInternalData(*proto_db_ptr),
+            DeserializeContractionHierarchy(*proto_db_ptr) };
+    };
+    
+    return { std::move(db), std::move(renderer), std::move(router), DeserializeGraph(proto_db), DeserializeStopVertices(proto_db), std::move(load_router_data) };
 }
 
 void SerializeStops(const transport::Catalogue& db, proto_transport::TransportCatalogue& proto_db) {
-    const auto all_stops = db.GetSortedAllStops();
-    for (const auto& stop : all_stops) {
+    for (uint32_t stop_id = 0; stop_id < db.GetStopCount(); ++stop_id) {
+        const transport::Stop* stop = db.GetStop(stop_id);
         proto_transport::Stop proto_stop;
-        proto_stop.set_name(stop.second->name);
-        proto_stop.mutable_coordinates()->set_lat(stop.second->coordinates.lat);
-        proto_stop.mutable_coordinates()->set_lng(stop.second->coordinates.lng);
-        for (const auto& bus : stop.second->buses_by_stop) {
+        proto_stop.set_name(stop->name);
+        proto_stop.mutable_coordinates()->set_lat(stop->coordinates.lat);
+        proto_stop.mutable_coordinates()->set_lng(stop->coordinates.lng);
+        for (const auto& bus : stop->buses_by_stop) {
             proto_stop.add_buses_by_stop(bus);
         }
         *proto_db.add_stops() = std::move(proto_stop);
@@ -48,25 +124,30 @@ void SerializeStops(const transport::Catalogue& db, proto_transport::TransportCa
 }
 
 void SerializeStopDistances(const transport::Catalogue& db, proto_transport::TransportCatalogue& proto_db) {
-    for (const auto& [stop_pair, distance] : db.GetStopDistances()) {
-        proto_transport::StopDistanses proto_stop_distances;
-        proto_stop_distances.set_from(stop_pair.first->name);
-        proto_stop_distances.set_to(stop_pair.second->name);
-        proto_stop_distances.set_distance(distance);
-
-        *proto_db.add_stop_distances() = std::move(proto_stop_distances);
+    const transport::DistanceTable& distances = db.GetStopDistances();
+    proto_db.mutable_stop_distances()->Reserve(static_cast<int>(distances.GetSize()));
+    for (const auto& [from, to, distance] : distances) {
+        proto_transport::StopDistanses* proto_stop_distances = proto_db.add_stop_distances();
+        proto_stop_distances->set_from(from);
+        proto_stop_distances->set_to(to);
+        proto_stop_distances->set_distance(distance);
     }
 }
 
 void SerializeBuses(const transport::Catalogue& db, proto_transport::TransportCatalogue& proto_db) {
-    const auto all_buses = db.GetSortedAllBuses();
-    for (const auto& bus : all_buses) {
+    for (const transport::Bus* bus : db.GetSortedAllBuses()) {
         proto_transport::Bus proto_bus;
-        proto_bus.set_number(bus.second->number);
-        for (const auto* stop : bus.second->stops) {
-            *proto_bus.mutable_stops()->Add() = stop->name;
+        proto_bus.set_number(bus->number);
+        for (const auto* stop : bus->stops) {
+            proto_bus.add_stops(stop->id);
         }
-        proto_bus.set_is_circle(bus.second->is_circle);
+        proto_bus.set_is_circle(bus->is_circle);
+        const transport::BusStat& bus_stat = db.GetBusStat(bus);
+        proto_transport::BusStat& proto_bus_stat = *proto_bus.mutable_stat();
+        proto_bus_stat.set_stops_count(static_cast<int32_t>(bus_stat.stops_count));
+        proto_bus_stat.set_unique_stops_count(static_cast<int32_t>(bus_stat.unique_stops_count));
+        proto_bus_stat.set_route_length(bus_stat.route_length);
+        proto_bus_stat.set_curvature(bus_stat.curvature);
         
         *proto_db.add_buses() = std::move(proto_bus);
     }
@@ -140,32 +221,61 @@ proto_map::Rgba SerializeRgba(const svg::Rgba& rgba) {
 
 void SerializeRouter(const transport::Router& router, proto_transport::TransportCatalogue& proto_db) {
     proto_transport::Router proto_router;
-    *proto_router.mutable_router_settings() = SerializeRouterSettings(router.GetRouterSettings(), proto_db);
+    *proto_router.mutable_router_settings() = SerializeRouterSettings(router.GetRoutingSettings(), proto_db);
     *proto_router.mutable_graph() = SerializeGraph(router, proto_db);
-    for (const auto& [name, id] : router.GetStopIds()) {
-        proto_transport::StopId proto_stop_id;
-        proto_stop_id.set_name(name);
-        proto_stop_id.set_id(id);
-        
-        *proto_router.add_stop_ids() = proto_stop_id;
+    for (const graph::VertexId vertex : router.GetStopVertices()) {
+        proto_router.add_stop_vertex(vertex);
+    }
+    if (router.HasContractionHierarchy()) {
+        *proto_router.mutable_contraction_hierarchy() = SerializeContractionHierarchy(router);
     }
     *proto_db.mutable_router() = std::move(proto_router);
 }
 
-proto_transport::RouterSettings SerializeRouterSettings(const transport::Router& router, proto_transport::TransportCatalogue& proto_db) {
+proto_transport::RouterSettings SerializeRouterSettings(const transport::RoutingSettings& settings, proto_transport::TransportCatalogue& proto_db) {
     proto_transport::RouterSettings proto_router_settings;
-    proto_router_settings.set_bus_wait_time(router.GetBusWaitTime());
-    proto_router_settings.set_bus_velocity(router.GetBusVelocity());
+    proto_router_settings.set_bus_wait_time(settings.bus_wait_time);
+    proto_router_settings.set_bus_velocity(settings.bus_velocity);
+    proto_router_settings.set_prune_dominated_edges(settings.prune_dominated_edges);
+    proto_router_settings.set_route_cache_size(settings.route_cache_size);
+    proto_router_settings.set_compact_routes_table(settings.compact_routes_table);
+    proto_router_settings.set_graph_layout(settings.graph_layout == transport::GraphLayout::ROUTE_PATTERNS
+        ? proto_transport::ROUTE_PATTERNS : proto_transport::STOP_PAIRS);
+    switch (settings.vertex_order) {
+        case transport::VertexOrder::REVERSE_CUTHILL_MCKEE:
+            proto_router_settings.set_vertex_order(proto_transport::REVERSE_CUTHILL_MCKEE);
+            break;
+        case transport::VertexOrder::HILBERT_CURVE:
+            proto_router_settings.set_vertex_order(proto_transport::HILBERT_CURVE);
+            break;
+        default:
+            proto_router_settings.set_vertex_order(proto_transport::NAME);
+            break;
+    }
+    switch (settings.routing_mode) {
+        case transport::RoutingMode::ALL_PAIRS:
+            proto_router_settings.set_routing_mode(proto_transport::ALL_PAIRS);
+            break;
+        case transport::RoutingMode::DIJKSTRA:
+            proto_router_settings.set_routing_mode(proto_transport::DIJKSTRA);
+            break;
+        case transport::RoutingMode::CONTRACTION_HIERARCHY:
+            proto_router_settings.set_routing_mode(proto_transport::CONTRACTION_HIERARCHY);
+            break;
+        case transport::RoutingMode::RAPTOR:
+            proto_router_settings.set_routing_mode(proto_transport::RAPTOR);
+            break;
+    }
     
     return proto_router_settings;
 }
 
 proto_graph::Graph SerializeGraph(const transport::Router& router, proto_transport::TransportCatalogue& proto_db) {
     proto_graph::Graph proto_graph;
-    for (int i = 0; i < router.GetGraph().GetEdgeCount(); ++i) {
-        const graph::Edge edge = router.GetGraph().GetEdge(i);
+    for (size_t i = 0; i < router.GetGraph().GetEdgeCount(); ++i) {
+        const graph::Edge<double>& edge = router.GetGraph().GetEdge(i);
         proto_graph::Edge proto_edge;
-        proto_edge.set_name(edge.name);
+        proto_edge.set_name_id(edge.name_id);
         proto_edge.set_quality(edge.quality);
         proto_edge.set_from(edge.from);
         proto_edge.set_to(edge.to);
@@ -173,41 +283,78 @@ proto_graph::Graph SerializeGraph(const transport::Router& router, proto_transpo
 
         *proto_graph.add_edge() = proto_edge;
     }
-    for (int i = 0; i < router.GetGraph().GetVertexCount(); ++i) {
-        proto_graph::Vertex proto_vertex;
-        for (const auto& edge_id : router.GetGraph().GetIncidentEdges(i)) {
-            proto_vertex.add_edge_id(edge_id);
-        }
-        *proto_graph.add_vertex() = proto_vertex;
+    for (const graph::EdgeId offset : router.GetGraph().GetOffsets()) {
+        proto_graph.add_offset(offset);
     }
     return proto_graph;
 }
 
+void SerializeRoutesInternalData(const transport::Router& router, proto_transport::TransportCatalogue& proto_db) {
+    proto_transport::RoutesInternalData proto_routes;
+    if (router.HasRoutesInternalData()) {
+        SerializeRoutesCells<graph::Router<double>>(router.GetRoutesInternalData(), proto_routes, [&proto_routes](double weight) {
+            proto_routes.add_weight(weight);
+        });
+    }
+    else if (router.HasCompactRoutesInternalData()) {
+        SerializeRoutesCells<graph::Router<double, graph::CompactRoutesStorage>>(router.GetCompactRoutesInternalData(), proto_routes, [&proto_routes](float weight) {
+            proto_routes.add_compact_weight(weight);
+        });
+    }
+    else {
+        return;
+    }
+    *proto_db.mutable_routes_internal_data() = std::move(proto_routes);
+}
+
+proto_transport::ContractionHierarchy SerializeContractionHierarchy(const transport::Router& router) {
+    const auto& hierarchy_data = router.GetHierarchyData();
+    proto_transport::ContractionHierarchy proto_hierarchy;
+    proto_hierarchy.mutable_rank()->Reserve(hierarchy_data.ranks.size());
+    for (const size_t rank : hierarchy_data.ranks) {
+        proto_hierarchy.add_rank(rank);
+    }
+    for (const auto& shortcut : hierarchy_data.shortcuts) {
+        proto_transport::Shortcut proto_shortcut;
+        proto_shortcut.set_from(shortcut.from);
+        proto_shortcut.set_to(shortcut.to);
+        proto_shortcut.set_weight(shortcut.weight);
+        proto_shortcut.set_first_edge(shortcut.first_edge);
+        proto_shortcut.set_second_edge(shortcut.second_edge);
+
+        *proto_hierarchy.add_shortcut() = std::move(proto_shortcut);
+    }
+    return proto_hierarchy;
+}
+
 void DeserializeStops(transport::Catalogue& db, const proto_transport::TransportCatalogue& proto_db) {
-    for (int i = 0; i < proto_db.stops_size(); ++i) {
-        const proto_transport::Stop& proto_stop = proto_db.stops(i);
-        db.AddStop(proto_stop.name(), { proto_stop.coordinates().lat(), proto_stop.coordinates().lng() });
+    std::vector<transport::Catalogue::StopEntry> stops;
+    stops.reserve(proto_db.stops_size());
+    for (const proto_transport::Stop& proto_stop : proto_db.stops()) {
+        stops.push_back({ proto_stop.name(), { proto_stop.coordinates().lat(), proto_stop.coordinates().lng() } });
     }
+    db.AddStops(stops);
 }
 
 void DeserializeStopDistances(transport::Catalogue& db, const proto_transport::TransportCatalogue& proto_db) {
-    for (int i = 0; i < proto_db.stop_distances_size(); ++i) {
-        const proto_transport::StopDistanses& proto_stop_distances = proto_db.stop_distances(i);
-        const transport::Stop* from = db.FindStop(proto_stop_distances.from());
-        const transport::Stop* to = db.FindStop(proto_stop_distances.to());
-        db.SetDistance(from, to, proto_stop_distances.distance());
+    std::vector<transport::Catalogue::DistanceEntry> distances;
+    distances.reserve(proto_db.stop_distances_size());
+    for (const proto_transport::StopDistanses& proto_stop_distances : proto_db.stop_distances()) {
+        distances.push_back({ proto_stop_distances.from(), proto_stop_distances.to(), proto_stop_distances.distance() });
     }
+    db.AddDistances(distances);
 }
 
 void DeserializeBuses(transport::Catalogue& db, const proto_transport::TransportCatalogue& proto_db) {
-    for (int i = 0; i < proto_db.buses_size(); ++i) {
-        const proto_transport::Bus& proto_bus = proto_db.buses(i);
-        std::vector<const transport::Stop*> stops(proto_bus.stops_size());
-        for (int j = 0; j < stops.size(); ++j) {
-            stops[j] = db.FindStop(proto_bus.stops(j));
-        }
-        db.AddRoute(proto_bus.number(), stops, proto_bus.is_circle());
+    std::vector<transport::Catalogue::BusEntry> buses;
+    buses.reserve(proto_db.buses_size());
+    for (const proto_transport::Bus& proto_bus : proto_db.buses()) {
+        const proto_transport::BusStat& proto_bus_stat = proto_bus.stat();
+        buses.push_back({ proto_bus.number(), { proto_bus.stops().begin(), proto_bus.stops().end() }, proto_bus.is_circle(),
+            transport::BusStat{ static_cast<size_t>(proto_bus_stat.stops_count()), static_cast<size_t>(proto_bus_stat.unique_stops_count()),
+                proto_bus_stat.route_length(), proto_bus_stat.curvature() } });
     }
+    db.AddRoutes(buses);
 }
 
 renderer::MapRenderer DeserializeRenderSettings(renderer::RenderSettings& render_settings, const proto_transport::TransportCatalogue& proto_db) {
@@ -247,37 +394,87 @@ svg::Color DeserializeColor(const proto_map::Color& proto_color) {
 }
 
 transport::Router DeserializeRouterSettings(const proto_transport::TransportCatalogue& proto_db) {
-    return { proto_db.router().router_settings().bus_wait_time(), proto_db.router().router_settings().bus_velocity()};
+    const proto_transport::RouterSettings& proto_router_settings = proto_db.router().router_settings();
+    transport::RoutingSettings settings;
+    settings.bus_wait_time = proto_router_settings.bus_wait_time();
+    settings.bus_velocity = proto_router_settings.bus_velocity();
+    settings.prune_dominated_edges = proto_router_settings.prune_dominated_edges();
+    settings.route_cache_size = proto_router_settings.route_cache_size();
+    settings.compact_routes_table = proto_router_settings.compact_routes_table();
+    settings.graph_layout = proto_router_settings.graph_layout() == proto_transport::ROUTE_PATTERNS
+        ? transport::GraphLayout::ROUTE_PATTERNS : transport::GraphLayout::STOP_PAIRS;
+    switch (proto_router_settings.vertex_order()) {
+        case proto_transport::REVERSE_CUTHILL_MCKEE:
+            settings.vertex_order = transport::VertexOrder::REVERSE_CUTHILL_MCKEE;
+            break;
+        case proto_transport::HILBERT_CURVE:
+            settings.vertex_order = transport::VertexOrder::HILBERT_CURVE;
+            break;
+        default:
+            settings.vertex_order = transport::VertexOrder::NAME;
+            break;
+    }
+    switch (proto_router_settings.routing_mode()) {
+        case proto_transport::DIJKSTRA:
+            settings.routing_mode = transport::RoutingMode::DIJKSTRA;
+            break;
+        case proto_transport::CONTRACTION_HIERARCHY:
+            settings.routing_mode = transport::RoutingMode::CONTRACTION_HIERARCHY;
+            break;
+        case proto_transport::RAPTOR:
+            settings.routing_mode = transport::RoutingMode::RAPTOR;
+            break;
+        default:
+            settings.routing_mode = transport::RoutingMode::ALL_PAIRS;
+            break;
+    }
+    return settings;
 }
 
 graph::DirectedWeightedGraph<double> DeserializeGraph(const proto_transport::TransportCatalogue& proto_db) {
     const proto_graph::Graph& proto_graph = proto_db.router().graph();
     std::vector<graph::Edge<double>> edges(proto_graph.edge_size());
-    std::vector<std::vector<graph::EdgeId>> incidence_lists(proto_graph.vertex_size());
     for (int i = 0; i < proto_graph.edge_size(); ++i) {
         const proto_graph::Edge& proto_edge = proto_graph.edge(i);
-        edges[i] = { proto_edge.name(),
-                     static_cast<size_t>(proto_edge.quality()),
-                     static_cast<size_t>(proto_edge.from()),
-                     static_cast<size_t>(proto_edge.to()),
+        edges[i] = { proto_edge.name_id(),
+                     static_cast<uint32_t>(proto_edge.quality()),
+                     static_cast<uint32_t>(proto_edge.from()),
+                     static_cast<uint32_t>(proto_edge.to()),
                      proto_edge.weight() };
     }
-    for (size_t i = 0; i < incidence_lists.size(); ++i) {
-        const proto_graph::Vertex& proto_vertex = proto_graph.vertex(i);
-        incidence_lists[i].reserve(proto_vertex.edge_id_size());
-        for (const auto& id : proto_vertex.edge_id()) {
-            incidence_lists[i].push_back(id);
-        }
-    }
-    return graph::DirectedWeightedGraph<double>(edges, incidence_lists);
+    std::vector<graph::EdgeId> offsets(proto_graph.offset().begin(), proto_graph.offset().end());
+    return graph::DirectedWeightedGraph<double>(std::move(edges), std::move(offsets));
+}
+
+std::vector<graph::VertexId> DeserializeStopVertices(const proto_transport::TransportCatalogue& proto_db) {
+    return { proto_db.router().stop_vertex().begin(), proto_db.router().stop_vertex().end() };
+}
+
+graph::Router<double>::RoutesInternalData DeserializeRoutesInternalData(const proto_transport::TransportCatalogue& proto_db) {
+    const proto_transport::RoutesInternalData& proto_routes = proto_db.routes_internal_data();
+    if (proto_routes.weight_size() == 0) return {};
+    return DeserializeRoutesCells<graph::Router<double>>(proto_db, proto_routes.weight());
+}
+
+graph::Router<double, graph::CompactRoutesStorage>::RoutesInternalData DeserializeCompactRoutesInternalData(const proto_transport::TransportCatalogue& proto_db) {
+    const proto_transport::RoutesInternalData& proto_routes = proto_db.routes_internal_data();
+    if (proto_routes.compact_weight_size() == 0) return {};
+    return DeserializeRoutesCells<graph::Router<double, graph::CompactRoutesStorage>>(proto_db, proto_routes.compact_weight());
 }
 
-std::map<std::string, graph::VertexId> DeserializeStopIds(const proto_transport::TransportCatalogue& proto_db) {
-    std::map<std::string, graph::VertexId> stop_ids;
-    for (const auto& proto_stop_id : proto_db.router().stop_ids()) {
-        stop_ids[proto_stop_id.name()] = proto_stop_id.id();
+graph::ContractionHierarchy<double>::HierarchyData DeserializeContractionHierarchy(const proto_transport::TransportCatalogue& proto_db) {
+    const proto_transport::ContractionHierarchy& proto_hierarchy = proto_db.router().contraction_hierarchy();
+    graph::ContractionHierarchy<double>::HierarchyData hierarchy_data;
+    hierarchy_data.ranks.assign(proto_hierarchy.rank().begin(), proto_hierarchy.rank().end());
+    hierarchy_data.shortcuts.reserve(proto_hierarchy.shortcut_size());
+    for (const auto& proto_shortcut : proto_hierarchy.shortcut()) {
+        hierarchy_data.shortcuts.push_back({ proto_shortcut.from(),
+                                             proto_shortcut.to(),
+                                             proto_shortcut.weight(),
+                                             static_cast<graph::EdgeId>(proto_shortcut.first_edge()),
+                                             static_cast<graph::EdgeId>(proto_shortcut.second_edge()) });
     }
-    return stop_ids;
+    return hierarchy_data;
 }
 
 } // serialization
\ No newline at end of file
@@ -10,7 +10,7 @@
 namespace serialization {
 
 void Serialize(const transport::Catalogue& db, const renderer::MapRenderer& renderer, const transport::Router& router, std::ostream& out);
-std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router, graph::DirectedWeightedGraph<double>, std::map<std::string, graph::VertexId>> Deserialize(std::istream& input);
+std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router, graph::DirectedWeightedGraph<double>, std::vector<graph::VertexId>, transport::RouterDataLoader> Deserialize(std::istream& input);
 
 void SerializeStops(const transport::Catalogue& db, proto_transport::TransportCatalogue& proto_db);
 void SerializeStopDistances(const transport::Catalogue& db, proto_transport::TransportCatalogue& proto_db);
@@ -21,8 +21,10 @@ proto_map::Color SerializeColor(const svg::Color& color);
 proto_map::Rgb SerializeRgb(const svg::Rgb& rgb);
 proto_map::Rgba SerializeRgba(const svg::Rgba& rgba);
 void SerializeRouter(const transport::Router& router, proto_transport::TransportCatalogue& proto_db);
-proto_transport::RouterSettings SerializeRouterSettings(const transport::Router& router, proto_transport::TransportCatalogue& proto_db);
+proto_transport::RouterSettings SerializeRouterSettings(const transport::RoutingSettings& settings, proto_transport::TransportCatalogue& proto_db);
 proto_graph::Graph SerializeGraph(const transport::Router& router, proto_transport::TransportCatalogue& proto_db);
+void SerializeRoutesInternalData(const transport::Router& router, proto_transport::TransportCatalogue& proto_db);
+proto_transport::ContractionHierarchy SerializeContractionHierarchy(const transport::Router& router);
 
 void DeserializeStops(transport::Catalogue& db, const proto_transport::TransportCatalogue& proto_db);
 void DeserializeStopDistances(transport::Catalogue& db, const proto_transport::TransportCatalogue& proto_db);
@@ -32,6 +34,9 @@ svg::Point DeserializePoint(const proto_map::Point& proto_point);
 svg::Color DeserializeColor(const proto_map::Color& proto_color);
 transport::Router DeserializeRouterSettings(const proto_transport::TransportCatalogue& proto_db);
 graph::DirectedWeightedGraph<double> DeserializeGraph(const proto_transport::TransportCatalogue& proto_db);
-std::map<std::string, graph::VertexId> DeserializeStopIds(const proto_transport::TransportCatalogue& proto_db);
+std::vector<graph::VertexId> DeserializeStopVertices(const proto_transport::TransportCatalogue& proto_db);
+graph::Router<double>::RoutesInternalData DeserializeRoutesInternalData(const proto_transport::TransportCatalogue& proto_db);
+graph::Router<double, graph::CompactRoutesStorage>::RoutesInternalData DeserializeCompactRoutesInternalData(const proto_transport::TransportCatalogue& proto_db);
+graph::ContractionHierarchy<double>::HierarchyData DeserializeContractionHierarchy(const proto_transport::TransportCatalogue& proto_db);
 
 } // serialization
\ No newline at end of file
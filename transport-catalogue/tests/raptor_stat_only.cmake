@@ -0,0 +1,81 @@
+# В режиме RAPTOR движок собирается в фоне, а при одних запросах Bus и Stop программа
+# завершается, не дожидаясь его. Справочник к этому моменту уже уничтожен, и фоновая
+# сборка не должна к нему обращаться. База нужна достаточно большая, чтобы сборка
+# не успевала закончиться раньше ответов; обращения к памяти ловит сборка с -fsanitize=address.
+# Запуск: cmake -DBINARY=... -P raptor_stat_only.cmake
+
+set(STOP_COUNT 1000)
+set(BUS_COUNT 600)
+set(BUS_LENGTH 20)
+
+set(db_file "${CMAKE_CURRENT_BINARY_DIR}/raptor_stat_only.db")
+set(serialization_settings "\"serialization_settings\": { \"file\": \"${db_file}\" }")
+
+# Остановки на одной линии, соседние в 1000 м друг от друга.
+# Автобус Bi некольцевой и проходит остановки Si .. Si+BUS_LENGTH-1
+set(base_requests "")
+math(EXPR last_stop "${STOP_COUNT} - 1")
+foreach(stop RANGE ${last_stop})
+    math(EXPR next_stop "${stop} + 1")
+    set(road_distances "")
+    if(stop LESS last_stop)
+        set(road_distances "\"S${next_stop}\": 1000")
+    endif()
+    string(APPEND base_requests "{ \"type\": \"Stop\", \"name\": \"S${stop}\", \"latitude\": 55.${stop}, \"longitude\": 37.${stop}, \"road_distances\": { ${road_distances} } },\n")
+endforeach()
+math(EXPR last_bus "${BUS_COUNT} - 1")
+foreach(bus RANGE ${last_bus})
+    set(stops "")
+    math(EXPR last_bus_stop "${bus} + ${BUS_LENGTH} - 1")
+    foreach(stop RANGE ${bus} ${last_bus_stop})
+        if(NOT stop EQUAL bus)
+            string(APPEND stops ", ")
+        endif()
+        string(APPEND stops "\"S${stop}\"")
+    endforeach()
+    if(NOT bus EQUAL 0)
+        string(APPEND base_requests ",\n")
+    endif()
+    string(APPEND base_requests "{ \"type\": \"Bus\", \"name\": \"B${bus}\", \"stops\": [ ${stops} ], \"is_roundtrip\": false }")
+endforeach()
+
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/raptor_stat_only_make_base.json" "{
+${serialization_settings},
+\"routing_settings\": { \"bus_wait_time\": 6, \"bus_velocity\": 40, \"routing_mode\": \"raptor\" },
+\"render_settings\": { \"width\": 600, \"height\": 400, \"padding\": 50, \"stop_radius\": 5, \"line_width\": 14,
+    \"bus_label_font_size\": 20, \"bus_label_offset\": [ 7, 15 ], \"stop_label_font_size\": 20, \"stop_label_offset\": [ 7, -3 ],
+    \"underlayer_color\": [ 255, 255, 255, 0.85 ], \"underlayer_width\": 3, \"color_palette\": [ \"green\", \"red\" ] },
+\"base_requests\": [
+${base_requests}
+]
+}")
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/raptor_stat_only_process_requests.json" "{
+${serialization_settings},
+\"stat_requests\": [
+{ \"id\": 1, \"type\": \"Bus\", \"name\": \"B0\" },
+{ \"id\": 2, \"type\": \"Stop\", \"name\": \"S0\" }
+]
+}")
+
+execute_process(COMMAND ${BINARY} make_base
+    INPUT_FILE "${CMAKE_CURRENT_BINARY_DIR}/raptor_stat_only_make_base.json"
+    RESULT_VARIABLE make_base_result)
+if(NOT make_base_result EQUAL 0)
+    message(FATAL_ERROR "make_base failed: ${make_base_result}")
+endif()
+
+execute_process(COMMAND ${BINARY} process_requests
+    INPUT_FILE "${CMAKE_CURRENT_BINARY_DIR}/raptor_stat_only_process_requests.json"
+    OUTPUT_VARIABLE output
+    RESULT_VARIABLE process_requests_result)
+if(NOT process_requests_result EQUAL 0)
+    message(FATAL_ERROR "process_requests failed: ${process_requests_result}")
+endif()
+
+# B0: 20 остановок туда и обратно по 1000 м
+foreach(expected "\"route_length\": 38000" "\"stop_count\": 39" "\"unique_stop_count\": 20" "\"B0\"")
+    string(FIND "${output}" "${expected}" position)
+    if(position EQUAL -1)
+        message(FATAL_ERROR "Expected ${expected} in output:\n${output}")
+    endif()
+endforeach()
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace parallel {
+
+size_t DefaultThreadCount() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    const size_t worker_count = thread_count > 1 ? thread_count - 1 : 0;
+    workers_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    task_ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size() + 1;
+}
+
+void ThreadPool::Run(size_t count, std::function<void(size_t)> task) {
+    {
+        std::lock_guard lock(mutex_);
+        task_ = std::move(task);
+        task_count_ = count;
+        next_index_ = 0;
+        active_workers_ = workers_.size();
+        ++generation_;
+    }
+    task_ready_.notify_all();
+    RunIndices();
+
+    std::unique_lock lock(mutex_);
+    task_done_.wait(lock, [this] { return active_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::RunIndices() {
+    for (size_t index = next_index_++; index < task_count_; index = next_index_++) {
+        task_(index);
+    }
+}
+
+void ThreadPool::WorkerLoop() {
+    size_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            task_ready_.wait(lock, [this, seen_generation] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        RunIndices();
+        {
+            std::lock_guard lock(mutex_);
+            if (--active_workers_ == 0) {
+                task_done_.notify_one();
+            }
+        }
+    }
+}
+
+} // namespace parallel
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+size_t DefaultThreadCount();
+
+// Пул потоков для параллельных циклов: потоки создаются один раз и
+// переиспользуются, вызывающий поток тоже участвует в работе.
+// ParallelFor не реентерабелен, а задачи не должны бросать исключений
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = DefaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const;
+
+    // Вызывает func(index) для каждого index из [0, count) и дожидается завершения всех вызовов
+    template <typename Func>
+    void ParallelFor(size_t count, Func&& func) {
+        if (workers_.empty() || count < 2) {
+            for (size_t index = 0; index < count; ++index) {
+                func(index);
+            }
+            return;
+        }
+        Run(count, std::function<void(size_t)>(std::ref(func)));
+    }
+
+private:
+    void Run(size_t count, std::function<void(size_t)> task);
+    void RunIndices();
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::condition_variable task_done_;
+    std::function<void(size_t)> task_;
+    size_t task_count_ = 0;
+    std::atomic<size_t> next_index_{ 0 };
+    size_t generation_ = 0;
+    size_t active_workers_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace parallel
\ No newline at end of file
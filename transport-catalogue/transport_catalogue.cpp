@@ -1,20 +1,110 @@
 #include "transport_catalogue.h"
+#include "thread_pool.h"
+
+#include <algorithm>
 
 namespace transport {
 
+namespace {
+
+bool StopNameLess(const Stop* lhs, const Stop* rhs) {
+    return lhs->name < rhs->name;
+}
+
+bool BusNumberLess(const Bus* lhs, const Bus* rhs) {
+    return lhs->number < rhs->number;
+}
+
+// Вставка с сохранением порядка. Одноимённый элемент заменяется, как и в таблице названий
+template <typename T, typename Less>
+void InsertSorted(std::vector<const T*>& sorted, const T* item, Less less) {
+    const auto it = std::lower_bound(sorted.begin(), sorted.end(), item, less);
+    if (it != sorted.end() && !less(item, *it)) {
+        *it = item;
+    }
+    else {
+        sorted.insert(it, item);
+    }
+}
+
+// Пачка упорядочивается один раз целиком по таблице названий
+template <typename T, typename Less>
+void SortAll(std::vector<const T*>& sorted, const std::unordered_map<std::string_view, const T*>& by_name, Less less) {
+    sorted.clear();
+    sorted.reserve(by_name.size());
+    for (const auto& [name, item] : by_name) {
+        sorted.push_back(item);
+    }
+    std::sort(sorted.begin(), sorted.end(), less);
+}
+
+} // namespace
+
 void Catalogue::AddStop(std::string_view stop_name, const geo::Coordinates coordinates) {
-    all_stops_.push_back({ std::string(stop_name), coordinates, {} });
-    stopname_to_stop_[all_stops_.back().name] = &all_stops_.back();
+    InsertSorted(sorted_stops_, PushStop(stop_name, coordinates), StopNameLess);
 }
 
-void Catalogue::AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle) {
-    all_buses_.push_back({ std::string(bus_number), stops, is_circle });
-    busname_to_bus_[all_buses_.back().number] = &all_buses_.back();
-    for (const auto& route_stop : stops) {
-        for (auto& stop_ : all_stops_) {
-            if (stop_.name == route_stop->name) stop_.buses_by_stop.insert(std::string(bus_number));
+void Catalogue::AddStops(const std::vector<StopEntry>& stops) {
+    stopname_to_stop_.reserve(stopname_to_stop_.size() + stops.size());
+    for (const auto& stop : stops) {
+        PushStop(stop.name, stop.coordinates);
+    }
+    SortAll(sorted_stops_, stopname_to_stop_, StopNameLess);
+}
+
+void Catalogue::AddDistances(const std::vector<DistanceEntry>& distances) {
+    stop_distances_.Reserve(stop_distances_.GetSize() + distances.size());
+    for (const auto& [from, to, distance] : distances) {
+        stop_distances_.Set(GetStop(from)->id, GetStop(to)->id, distance);
+    }
+}
+
+void Catalogue::AddRoutes(const std::vector<BusEntry>& buses) {
+    busname_to_bus_.reserve(busname_to_bus_.size() + buses.size());
+    bus_stats_.reserve(bus_stats_.size() + buses.size());
+    std::vector<const Bus*> computed_buses;
+    for (const auto& bus : buses) {
+        std::vector<const Stop*> stops;
+        stops.reserve(bus.stops.size());
+        for (const uint32_t stop_id : bus.stops) {
+            stops.push_back(GetStop(stop_id));
+        }
+        const Bus* added = PushBus(bus.number, std::move(stops), bus.is_circle);
+        if (bus.stat) {
+            bus_stats_[added->id] = *bus.stat;
         }
+        else {
+            computed_buses.push_back(added);
+        }
+    }
+    SortAll(sorted_buses_, busname_to_bus_, BusNumberLess);
+
+    // Статистика всех маршрутов пришла из базы - потоки не нужны
+    if (computed_buses.empty()) {
+        return;
+    }
+    parallel::ThreadPool thread_pool;
+    thread_pool.ParallelFor(computed_buses.size(), [this, &computed_buses](size_t index) {
+        bus_stats_[computed_buses[index]->id] = ComputeBusStat(*computed_buses[index]);
+    });
+}
+
+void Catalogue::AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle) {
+    const Bus* bus = PushBus(bus_number, stops, is_circle);
+    InsertSorted(sorted_buses_, bus, BusNumberLess);
+    bus_stats_[bus->id] = ComputeBusStat(*bus);
+}
+
+void Catalogue::RemoveRoute(std::string_view bus_number) {
+    const Bus* bus = FindRoute(bus_number);
+    if (!bus) {
+        throw std::out_of_range("Unknown bus " + std::string(bus_number));
+    }
+    for (const Stop* stop : bus->stops) {
+        all_stops_[stop->id].buses_by_stop.erase(bus->number);
     }
+    sorted_buses_.erase(std::lower_bound(sorted_buses_.begin(), sorted_buses_.end(), bus, BusNumberLess));
+    busname_to_bus_.erase(bus->number);
 }
 
 const Bus* Catalogue::FindRoute(std::string_view bus_number) const {
@@ -25,41 +115,116 @@ const Stop* Catalogue::FindStop(std::string_view stop_name) const {
     return stopname_to_stop_.count(stop_name) ? stopname_to_stop_.at(stop_name) : nullptr;
 }
 
-size_t Catalogue::UniqueStopsCount(std::string_view bus_number) const {
-    std::unordered_set<std::string_view> unique_stops;
-    for (const auto& stop : busname_to_bus_.at(bus_number)->stops) {
-        unique_stops.insert(stop->name);
+const Stop* Catalogue::GetStop(uint32_t stop_id) const {
+    if (stop_id >= all_stops_.size()) {
+        throw std::out_of_range("Unknown stop id " + std::to_string(stop_id));
     }
-    return unique_stops.size();
+    return &all_stops_[stop_id];
 }
 
+const Bus* Catalogue::GetBus(uint32_t bus_id) const {
+    if (bus_id >= all_buses_.size()) {
+        throw std::out_of_range("Unknown bus id " + std::to_string(bus_id));
+    }
+    return &all_buses_[bus_id];
+}
+
+size_t Catalogue::GetStopCount() const {
+    return all_stops_.size();
+}
+
+size_t Catalogue::GetBusCount() const {
+    return all_buses_.size();
+}
+
+size_t Catalogue::UniqueStopsCount(std::string_view bus_number) const {
+    return GetBusStat(busname_to_bus_.at(bus_number)).unique_stops_count;
+}
+
+const BusStat& Catalogue::GetBusStat(const Bus* bus) const {
+    return bus_stats_.at(bus->id);
+}
+
+// Расстояние входит в длину автобусов, проходящих через from
 void Catalogue::SetDistance(const Stop* from, const Stop* to, const int distance) {
-    stop_distances_[{from, to}] = distance;
+    stop_distances_.Set(from->id, to->id, distance);
+    for (const auto& bus_number : from->buses_by_stop) {
+        const Bus* bus = busname_to_bus_.at(bus_number);
+        bus_stats_[bus->id] = ComputeBusStat(*bus);
+    }
 }
 
 int Catalogue::GetDistance(const Stop* from, const Stop* to) const {
-    if (stop_distances_.count({ from, to })) return stop_distances_.at({ from, to });
-    else if (stop_distances_.count({ to, from })) return stop_distances_.at({ to, from });
-    else return 0;
+    return stop_distances_.Find(from->id, to->id).value_or(0);
 }
 
-const std::map<std::string_view, const Bus*> Catalogue::GetSortedAllBuses() const {
-    std::map<std::string_view, const Bus*> result;
-    for (const auto& bus : busname_to_bus_) {
-        result.emplace(bus);
-    }
-    return result;
+BusRange Catalogue::GetSortedAllBuses() const {
+    return ranges::AsRange(sorted_buses_);
 }
 
-const std::map<std::string_view, const Stop*> Catalogue::GetSortedAllStops() const {
-    std::map<std::string_view, const Stop*> result;
-    for (const auto& stop : stopname_to_stop_) {
-        result.emplace(stop);
-    }
-    return result;
+StopRange Catalogue::GetSortedAllStops() const {
+    return ranges::AsRange(sorted_stops_);
 }
 
-const std::unordered_map<std::pair<const Stop*, const Stop*>, int, Catalogue::StopDistancesHasher> Catalogue::GetStopDistances() const {
+const DistanceTable& Catalogue::GetStopDistances() const {
     return stop_distances_;
 }
+
+const Stop* Catalogue::PushStop(std::string_view stop_name, const geo::Coordinates coordinates) {
+    all_stops_.push_back({ std::string(stop_name), coordinates, {}, static_cast<uint32_t>(all_stops_.size()) });
+    stopname_to_stop_[all_stops_.back().name] = &all_stops_.back();
+    return &all_stops_.back();
+}
+
+const Bus* Catalogue::PushBus(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle) {
+    all_buses_.push_back({ std::string(bus_number), stops, is_circle, static_cast<uint32_t>(all_buses_.size()) });
+    busname_to_bus_[all_buses_.back().number] = &all_buses_.back();
+    bus_stats_.emplace_back();
+    IndexBusStops(all_buses_.back());
+    return &all_buses_.back();
+}
+
+// Остановки указывают на Stop этого справочника, поэтому изменяемый объект берётся по id
+void Catalogue::IndexBusStops(const Bus& bus) {
+    for (const Stop* stop : bus.stops) {
+        all_stops_[stop->id].buses_by_stop.insert(bus.number);
+    }
+}
+
+// Некольцевой маршрут проходится туда и обратно, в обратную сторону - по своим расстояниям
+BusStat Catalogue::ComputeBusStat(const Bus& bus) const {
+    const size_t stop_count = bus.stops.size();
+    BusStat bus_stat{};
+    if (stop_count == 0) {
+        return bus_stat;
+    }
+    bus_stat.stops_count = bus.is_circle ? stop_count : stop_count * 2 - 1;
+
+    int route_length = 0;
+    double geographic_length = 0.0;
+    for (size_t i = 1; i < stop_count; ++i) {
+        const Stop* from = bus.stops[i - 1];
+        const Stop* to = bus.stops[i];
+        const double segment_length = geo::ComputeDistance(from->coordinates, to->coordinates);
+        if (bus.is_circle) {
+            route_length += GetDistance(from, to);
+            geographic_length += segment_length;
+        }
+        else {
+            route_length += GetDistance(from, to) + GetDistance(to, from);
+            geographic_length += segment_length * 2;
+        }
+    }
+
+    std::vector<uint32_t> stop_ids;
+    stop_ids.reserve(stop_count);
+    for (const Stop* stop : bus.stops) {
+        stop_ids.push_back(stop->id);
+    }
+    std::sort(stop_ids.begin(), stop_ids.end());
+    bus_stat.unique_stops_count = std::unique(stop_ids.begin(), stop_ids.end()) - stop_ids.begin();
+    bus_stat.route_length = route_length;
+    bus_stat.curvature = route_length / geographic_length;
+    return bus_stat;
+}
 }  // namespace transport
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "distance_table.h"
 
 #include <iostream>
 #include <deque>
@@ -18,31 +19,71 @@ namespace transport {
 
 class Catalogue {
 public:
-    struct StopDistancesHasher {
-        size_t operator()(const std::pair<const Stop*, const Stop*>& points) const {
-            size_t hash_first = std::hash<const void*>{}(points.first);
-            size_t hash_second = std::hash<const void*>{}(points.second);
-            return hash_first + hash_second * 37;
-        }
+    // Записи для загрузки справочника пачками. Названия должны жить до конца вызова,
+    // остановки указываются по id
+    struct StopEntry {
+        std::string_view name;
+        geo::Coordinates coordinates;
+    };
+
+    struct DistanceEntry {
+        uint32_t from;
+        uint32_t to;
+        int distance;
+    };
+
+    struct BusEntry {
+        std::string_view number;
+        std::vector<uint32_t> stops;
+        bool is_circle;
+        // Готовая статистика из базы; без неё статистика считается при добавлении
+        std::optional<BusStat> stat = std::nullopt;
     };
 
     void AddStop(std::string_view stop_name, const geo::Coordinates coordinates);
+    // Пакетная загрузка: таблицы резервируются сразу под всю пачку. Неизвестный id остановки - std::out_of_range.
+    // Расстояния добавляются до автобусов: статистика автобусов пачки считается параллельно по уже известным расстояниям
+    void AddStops(const std::vector<StopEntry>& stops);
+    void AddDistances(const std::vector<DistanceEntry>& distances);
+    void AddRoutes(const std::vector<BusEntry>& buses);
     void AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle);
+    // Убирает автобус из справочника. Сам объект Bus остаётся в памяти, указатели на него не инвалидируются
+    void RemoveRoute(std::string_view bus_number);
     const Bus* FindRoute(std::string_view bus_number) const;
     const Stop* FindStop(std::string_view stop_name) const;
+    // Остановки и автобусы нумеруются подряд в порядке добавления. Удалённый автобус
+    // свой id не освобождает, и GetBus по нему по-прежнему возвращает объект
+    const Stop* GetStop(uint32_t stop_id) const;
+    const Bus* GetBus(uint32_t bus_id) const;
+    size_t GetStopCount() const;
+    size_t GetBusCount() const;
     size_t UniqueStopsCount(std::string_view bus_number) const;
+    // Статистика считается один раз при добавлении автобуса и пересчитывается при изменении расстояний его остановок
+    const BusStat& GetBusStat(const Bus* bus) const;
     void SetDistance(const Stop* from, const Stop* to, const int distance);
     int GetDistance(const Stop* from, const Stop* to) const;
-    const std::map<std::string_view, const Bus*> GetSortedAllBuses() const;
-    const std::map<std::string_view, const Stop*> GetSortedAllStops() const;
-    const std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> GetStopDistances() const;
+    // Автобусы и остановки по возрастанию названий. Порядок поддерживается при изменениях
+    // справочника, поэтому диапазоны отдаются без сортировки и действуют до следующего изменения
+    BusRange GetSortedAllBuses() const;
+    StopRange GetSortedAllStops() const;
+    // Явно заданные расстояния, обходятся прямо по таблице справочника
+    const DistanceTable& GetStopDistances() const;
 
 private:
     std::deque<Bus> all_buses_;
     std::deque<Stop> all_stops_;
     std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
     std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> stop_distances_;
+    DistanceTable stop_distances_;
+    std::vector<const Bus*> sorted_buses_;
+    std::vector<const Stop*> sorted_stops_;
+    // По id автобуса
+    std::vector<BusStat> bus_stats_;
+
+    const Stop* PushStop(std::string_view stop_name, const geo::Coordinates coordinates);
+    const Bus* PushBus(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle);
+    void IndexBusStops(const Bus& bus);
+    BusStat ComputeBusStat(const Bus& bus) const;
 };
 
 }  // namespace transport
\ No newline at end of file
@@ -2,94 +2,844 @@
 
 namespace transport {
 
+namespace {
+
+// Номер клетки на кривой Гильберта в решётке side x side, side - степень двойки
+uint64_t HilbertIndex(uint32_t side, uint32_t x, uint32_t y) {
+    uint64_t index = 0;
+    for (uint32_t half = side / 2; half > 0; half /= 2) {
+        const uint32_t rx = (x & half) > 0 ? 1 : 0;
+        const uint32_t ry = (y & half) > 0 ? 1 : 0;
+        index += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+// Остановки, близкие на кривой, близки и на карте
+std::vector<const Stop*> OrderByHilbertCurve(std::vector<const Stop*> stops) {
+    static constexpr uint32_t SIDE = 1u << 16;
+    if (stops.empty()) {
+        return stops;
+    }
+    const auto [min_lat, max_lat] = std::minmax_element(stops.begin(), stops.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->coordinates.lat < rhs->coordinates.lat;
+    });
+    const auto [min_lng, max_lng] = std::minmax_element(stops.begin(), stops.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->coordinates.lng < rhs->coordinates.lng;
+    });
+    const double lat_begin = (*min_lat)->coordinates.lat;
+    const double lng_begin = (*min_lng)->coordinates.lng;
+    const double lat_span = std::max((*max_lat)->coordinates.lat - lat_begin, std::numeric_limits<double>::min());
+    const double lng_span = std::max((*max_lng)->coordinates.lng - lng_begin, std::numeric_limits<double>::min());
+    const auto to_cell = [](double offset, double span) {
+        return static_cast<uint32_t>(std::min((offset / span) * (SIDE - 1), static_cast<double>(SIDE - 1)));
+    };
+
+    std::vector<std::pair<uint64_t, const Stop*>> keyed_stops;
+    keyed_stops.reserve(stops.size());
+    for (const Stop* stop : stops) {
+        keyed_stops.emplace_back(HilbertIndex(SIDE, to_cell(stop->coordinates.lng - lng_begin, lng_span),
+            to_cell(stop->coordinates.lat - lat_begin, lat_span)), stop);
+    }
+    // Остановки приходят по алфавиту, и стабильная сортировка сохраняет его внутри одной клетки
+    std::stable_sort(keyed_stops.begin(), keyed_stops.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    for (size_t i = 0; i < stops.size(); ++i) {
+        stops[i] = keyed_stops[i].second;
+    }
+    return stops;
+}
+
+// Соседние остановки получают близкие номера, и рёбра между ними ложатся
+// рядом в списках смежности и в таблице маршрутов. Соседями считаются
+// последовательные остановки любого автобуса
+std::vector<const Stop*> OrderByReverseCuthillMcKee(const Catalogue& catalogue, const std::vector<const Stop*>& stops) {
+    std::vector<uint32_t> stop_indices(catalogue.GetStopCount());
+    for (size_t i = 0; i < stops.size(); ++i) {
+        stop_indices[stops[i]->id] = static_cast<uint32_t>(i);
+    }
+    std::vector<std::vector<uint32_t>> neighbours(stops.size());
+    for (const Bus* bus_info : catalogue.GetSortedAllBuses()) {
+        for (size_t k = 1; k < bus_info->stops.size(); ++k) {
+            const uint32_t from = stop_indices[bus_info->stops[k - 1]->id];
+            const uint32_t to = stop_indices[bus_info->stops[k]->id];
+            if (from != to) {
+                neighbours[from].push_back(to);
+                neighbours[to].push_back(from);
+            }
+        }
+    }
+    for (auto& stop_neighbours : neighbours) {
+        std::sort(stop_neighbours.begin(), stop_neighbours.end());
+        stop_neighbours.erase(std::unique(stop_neighbours.begin(), stop_neighbours.end()), stop_neighbours.end());
+    }
+    const auto by_degree = [&neighbours](uint32_t lhs, uint32_t rhs) {
+        return neighbours[lhs].size() != neighbours[rhs].size() ? neighbours[lhs].size() < neighbours[rhs].size() : lhs < rhs;
+    };
+    for (auto& stop_neighbours : neighbours) {
+        std::sort(stop_neighbours.begin(), stop_neighbours.end(), by_degree);
+    }
+
+    // Каждая компонента обходится в ширину от вершины наименьшей степени
+    std::vector<uint32_t> starts(stops.size());
+    for (uint32_t i = 0; i < starts.size(); ++i) {
+        starts[i] = i;
+    }
+    std::sort(starts.begin(), starts.end(), by_degree);
+    std::vector<bool> visited(stops.size(), false);
+    std::vector<uint32_t> order;
+    order.reserve(stops.size());
+    for (const uint32_t start : starts) {
+        if (visited[start]) {
+            continue;
+        }
+        visited[start] = true;
+        order.push_back(start);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            for (const uint32_t neighbour : neighbours[order[head]]) {
+                if (!visited[neighbour]) {
+                    visited[neighbour] = true;
+                    order.push_back(neighbour);
+                }
+            }
+        }
+    }
+
+    std::vector<const Stop*> ordered_stops;
+    ordered_stops.reserve(stops.size());
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        ordered_stops.push_back(stops[*it]);
+    }
+    return ordered_stops;
+}
+
+} // namespace
+
 const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const Catalogue& catalogue) {
-    const auto& all_stops = catalogue.GetSortedAllStops();
-    const auto& all_buses = catalogue.GetSortedAllBuses();
-    graph::DirectedWeightedGraph<double> stops_graph(all_stops.size() * 2);
-    std::map<std::string, graph::VertexId> stop_ids;
-    graph::VertexId vertex_id = 0;
-
-    for (const auto& [stop_name, stop_info] : all_stops) {
-        stop_ids[stop_info->name] = vertex_id;
+    WaitWarmUp();
+    return BuildGraph(catalogue, OrderStops(catalogue));
+}
+
+// Остановке i соответствуют вершины 2i и 2i + 1 в любой раскладке,
+// вершины цепочек ROUTE_PATTERNS идут после вершин всех остановок
+const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const Catalogue& catalogue, std::vector<const Stop*> ordered_stops) {
+    stops_ = std::move(ordered_stops);
+    buses_.clear();
+    stop_vertices_.assign(catalogue.GetStopCount(), 0);
+    for (size_t i = 0; i < stops_.size(); ++i) {
+        stop_vertices_[stops_[i]->id] = static_cast<graph::VertexId>(i * 2);
+    }
+    for (const Bus* bus_info : catalogue.GetSortedAllBuses()) {
+        buses_.push_back(bus_info);
+    }
+
+    // RAPTOR ищет маршруты по самим автобусам, и рёбра поездок ему не нужны
+    const bool has_bus_edges = settings_.routing_mode != RoutingMode::RAPTOR;
+    const bool has_route_patterns = has_bus_edges && settings_.graph_layout == GraphLayout::ROUTE_PATTERNS;
+    const std::vector<RoutePattern> patterns = has_route_patterns ? BuildRoutePatterns(catalogue) : std::vector<RoutePattern>{};
+    size_t vertex_count = stops_.size() * 2;
+    for (const auto& pattern : patterns) {
+        vertex_count += pattern.stops.size();
+    }
+    graph::DirectedWeightedGraph<double> stops_graph(vertex_count);
+
+    for (size_t i = 0; i < stops_.size(); ++i) {
         stops_graph.AddEdge({
-                stop_info->name,
+                static_cast<uint32_t>(i),
                 0,
-                vertex_id,
-                ++vertex_id,
-                static_cast<double>(bus_wait_time_)
+                static_cast<uint32_t>(i * 2),
+                static_cast<uint32_t>(i * 2 + 1),
+                static_cast<double>(settings_.bus_wait_time)
             });
-        ++vertex_id;
-    }
-    stop_ids_ = std::move(stop_ids);
-
-    for_each(
-        all_buses.begin(),
-        all_buses.end(),
-        [&stops_graph, this, &catalogue](const auto& item) {
-            const auto& bus_info = item.second;
-            const auto& stops = bus_info->stops;
-            size_t stops_count = stops.size();
-            for (size_t i = 0; i < stops_count; ++i) {
-                for (size_t j = i + 1; j < stops_count; ++j) {
-                    const Stop* stop_from = stops[i];
-                    const Stop* stop_to = stops[j];
-                    int dist_sum = 0;
-                    int dist_sum_inverse = 0;
-                    for (size_t k = i + 1; k <= j; ++k) {
-                        dist_sum += catalogue.GetDistance(stops[k - 1], stops[k]);
-                        dist_sum_inverse += catalogue.GetDistance(stops[k], stops[k - 1]);
-                    }
-                    stops_graph.AddEdge({ bus_info->number,
-                                          j - i,
-                                          stop_ids_.at(stop_from->name) + 1,
-                                          stop_ids_.at(stop_to->name),
-                                          static_cast<double>(dist_sum) / (bus_velocity_ * (100.0 / 6.0))});
-
-                    if (!bus_info->is_circle) {
-                        stops_graph.AddEdge({ bus_info->number,
-                                              j - i,
-                                              stop_ids_.at(stop_to->name) + 1,
-                                              stop_ids_.at(stop_from->name),
-                                              static_cast<double>(dist_sum_inverse) / (bus_velocity_ * (100.0 / 6.0))});
-                    }
+    }
+
+    if (has_route_patterns) {
+        // Посадка и высадка бесплатны и помечены quality 0, как ожидание,
+        // каждая поездка на соседнюю остановку - quality 1
+        graph::VertexId pattern_vertex = static_cast<graph::VertexId>(stops_.size() * 2);
+        for (const auto& pattern : patterns) {
+            for (size_t k = 0; k < pattern.stops.size(); ++k) {
+                const graph::VertexId vertex = pattern_vertex + static_cast<graph::VertexId>(k);
+                const graph::VertexId stop_vertex = pattern.stops[k] * 2;
+                if (k + 1 < pattern.stops.size()) {
+                    stops_graph.AddEdge({ pattern.bus_id, 0, static_cast<uint32_t>(stop_vertex + 1), static_cast<uint32_t>(vertex), 0.0 });
+                    stops_graph.AddEdge({ pattern.bus_id, 1, static_cast<uint32_t>(vertex), static_cast<uint32_t>(vertex + 1),
+                        static_cast<double>(pattern.distances[k + 1] - pattern.distances[k]) / (settings_.bus_velocity * (100.0 / 6.0)) });
+                }
+                if (k > 0) {
+                    stops_graph.AddEdge({ pattern.bus_id, 0, static_cast<uint32_t>(vertex), static_cast<uint32_t>(stop_vertex), 0.0 });
                 }
             }
+            pattern_vertex += static_cast<graph::VertexId>(pattern.stops.size());
+        }
+    }
+    else {
+        // Рёбра каждого автобуса строятся независимо в собственный буфер,
+        // а затем буферы добавляются в граф в порядке автобусов
+        const size_t edge_bus_count = has_bus_edges ? buses_.size() : 0;
+        std::vector<std::vector<graph::Edge<double>>> bus_edges(edge_bus_count);
+        parallel::ThreadPool thread_pool;
+        thread_pool.ParallelFor(edge_bus_count, [this, &catalogue, &bus_edges](size_t bus_id) {
+            bus_edges[bus_id] = BuildBusEdges(catalogue, static_cast<uint32_t>(bus_id));
         });
+        for (const auto& edges : bus_edges) {
+            for (const auto& edge : edges) {
+                stops_graph.AddEdge(edge);
+            }
+        }
+    }
 
+    stops_graph.Freeze();
+    pruned_edge_count_ = settings_.prune_dominated_edges ? stops_graph.RemoveDominatedEdges() : 0;
     graph_ = std::move(stops_graph);
-    router_ = std::make_unique<graph::Router<double>>(graph_);
+    BuildRouter(catalogue);
 
     return graph_;
 }
 
-const std::optional<graph::Router<double>::RouteInfo> Router::FindRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-    return router_->BuildRoute(stop_ids_.at(std::string(stop_from)),stop_ids_.at(std::string(stop_to)));
+std::vector<graph::Edge<double>> Router::BuildBusEdges(const Catalogue& catalogue, uint32_t bus_id) const {
+    const Bus* bus_info = buses_[bus_id];
+    const auto& stops = bus_info->stops;
+    const size_t stops_count = stops.size();
+
+    // Префиксные суммы расстояний вдоль маршрута в прямом и обратном направлении:
+    // расстояние между i-й и j-й остановками считается за O(1)
+    std::vector<graph::VertexId> vertices(stops_count);
+    std::vector<int64_t> distances(stops_count, 0);
+    std::vector<int64_t> distances_inverse(stops_count, 0);
+    for (size_t k = 0; k < stops_count; ++k) {
+        vertices[k] = stop_vertices_[stops[k]->id];
+        if (k > 0) {
+            distances[k] = distances[k - 1] + catalogue.GetDistance(stops[k - 1], stops[k]);
+            distances_inverse[k] = distances_inverse[k - 1] + catalogue.GetDistance(stops[k], stops[k - 1]);
+        }
+    }
+
+    std::vector<graph::Edge<double>> edges;
+    const size_t pair_count = stops_count > 1 ? stops_count * (stops_count - 1) / 2 : 0;
+    edges.reserve(bus_info->is_circle ? pair_count : pair_count * 2);
+    for (size_t i = 0; i < stops_count; ++i) {
+        for (size_t j = i + 1; j < stops_count; ++j) {
+            edges.push_back({ bus_id,
+                              static_cast<uint32_t>(j - i),
+                              static_cast<uint32_t>(vertices[i] + 1),
+                              static_cast<uint32_t>(vertices[j]),
+                              static_cast<double>(distances[j] - distances[i]) / (settings_.bus_velocity * (100.0 / 6.0))});
+
+            if (!bus_info->is_circle) {
+                edges.push_back({ bus_id,
+                                  static_cast<uint32_t>(j - i),
+                                  static_cast<uint32_t>(vertices[j] + 1),
+                                  static_cast<uint32_t>(vertices[i]),
+                                  static_cast<double>(distances_inverse[j] - distances_inverse[i]) / (settings_.bus_velocity * (100.0 / 6.0))});
+            }
+        }
+    }
+    return edges;
+}
+
+// RAPTOR работает с номерами остановок: остановке i соответствуют вершины 2i и 2i + 1
+const std::optional<RouteInfo> Router::FindRoute(graph::VertexId from, graph::VertexId to) const {
+    if (ShouldFallBackToDijkstra()) {
+        return MakeRouteInfo(dijkstra_router_->BuildRoute(from, to));
+    }
+    WaitWarmUp();
+    switch (settings_.routing_mode) {
+        case RoutingMode::DIJKSTRA:
+            return MakeRouteInfo(dijkstra_router_->BuildRoute(from, to));
+        case RoutingMode::CONTRACTION_HIERARCHY:
+            return MakeRouteInfo(contraction_hierarchy_->BuildRoute(from, to));
+        case RoutingMode::RAPTOR:
+            return MakeRouteInfo(raptor_router_->BuildRoute(static_cast<uint32_t>(from / 2), static_cast<uint32_t>(to / 2)),
+                raptor_router_->GetBusWaitTime());
+        default:
+            return FindAllPairsRoute(from, to);
+    }
+}
+
+// Веса рёбер графа посчитаны для параметров из настроек, и предрасчёт ALL_PAIRS
+// и иерархии к другим параметрам не подходит. Такой запрос обслуживает поиск:
+// DijkstraRouter пересчитывает вес каждого ребра на лету (ожидание заменяется,
+// время поездки масштабируется по скорости), RAPTOR считает со своими параметрами
+const std::optional<RouteInfo> Router::FindRoute(graph::VertexId from, graph::VertexId to, const RoutingOverrides& overrides) const {
+    const double bus_wait_time = overrides.bus_wait_time.value_or(settings_.bus_wait_time);
+    const double bus_velocity = overrides.bus_velocity.value_or(settings_.bus_velocity);
+    if (bus_wait_time == settings_.bus_wait_time && bus_velocity == settings_.bus_velocity) {
+        return FindRoute(from, to);
+    }
+    if (bus_wait_time < 0.0 || !(bus_velocity > 0.0)) {
+        throw std::invalid_argument("Bus wait time should be non-negative and bus velocity positive");
+    }
+    if (settings_.routing_mode == RoutingMode::RAPTOR) {
+        WaitWarmUp();
+        return MakeRouteInfo(raptor_router_->BuildRoute(static_cast<uint32_t>(from / 2), static_cast<uint32_t>(to / 2),
+            bus_wait_time, bus_velocity), bus_wait_time);
+    }
+
+    // Ожидание - ребро между двумя вершинами одной остановки, у посадки и высадки
+    // ROUTE_PATTERNS тоже quality 0, но нулевой вес, который масштабирование не меняет
+    const graph::VertexId stop_vertex_count = static_cast<graph::VertexId>(stops_.size() * 2);
+    const double ride_scale = settings_.bus_velocity / bus_velocity;
+    const auto edge_weight = [stop_vertex_count, bus_wait_time, ride_scale](const graph::Edge<double>& edge) {
+        return edge.quality == 0 && edge.from < stop_vertex_count && edge.to < stop_vertex_count ? bus_wait_time
+                                                                                                : edge.weight * ride_scale;
+    };
+    auto route_info = MakeRouteInfo(dijkstra_router_->BuildRoute(from, to, edge_weight));
+    if (route_info) {
+        for (auto& edge : route_info->edges) {
+            edge.weight = edge_weight(edge);
+        }
+    }
+    return route_info;
+}
+
+std::vector<std::optional<RouteInfo>> Router::FindRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets) const {
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    if (ShouldFallBackToDijkstra()) {
+        for (const auto& route : dijkstra_router_->BuildRoutes(from, targets)) {
+            routes.push_back(MakeRouteInfo(route));
+        }
+        return routes;
+    }
+    WaitWarmUp();
+    switch (settings_.routing_mode) {
+        case RoutingMode::DIJKSTRA:
+            for (const auto& route : dijkstra_router_->BuildRoutes(from, targets)) {
+                routes.push_back(MakeRouteInfo(route));
+            }
+            break;
+        case RoutingMode::CONTRACTION_HIERARCHY:
+            for (const auto& route : contraction_hierarchy_->BuildRoutes(from, targets)) {
+                routes.push_back(MakeRouteInfo(route));
+            }
+            break;
+        case RoutingMode::RAPTOR: {
+            std::vector<uint32_t> target_stops;
+            target_stops.reserve(targets.size());
+            for (const graph::VertexId to : targets) {
+                target_stops.push_back(static_cast<uint32_t>(to / 2));
+            }
+            for (const auto& journey : raptor_router_->BuildRoutes(static_cast<uint32_t>(from / 2), target_stops)) {
+                routes.push_back(MakeRouteInfo(journey, raptor_router_->GetBusWaitTime()));
+            }
+            break;
+        }
+        default:
+            for (const graph::VertexId to : targets) {
+                routes.push_back(FindAllPairsRoute(from, to));
+            }
+            break;
+    }
+    return routes;
+}
+
+std::vector<double> Router::FindTravelTimes(const std::vector<graph::VertexId>& origins,
+    const std::vector<graph::VertexId>& targets) const {
+    if (ShouldFallBackToDijkstra()) {
+        return dijkstra_router_->BuildWeights(origins, targets);
+    }
+    WaitWarmUp();
+    switch (settings_.routing_mode) {
+        case RoutingMode::DIJKSTRA:
+            return dijkstra_router_->BuildWeights(origins, targets);
+        case RoutingMode::CONTRACTION_HIERARCHY:
+            return contraction_hierarchy_->BuildWeights(origins, targets);
+        case RoutingMode::RAPTOR: {
+            const auto to_stops = [](const std::vector<graph::VertexId>& vertices) {
+                std::vector<uint32_t> stops;
+                stops.reserve(vertices.size());
+                for (const graph::VertexId vertex : vertices) {
+                    stops.push_back(static_cast<uint32_t>(vertex / 2));
+                }
+                return stops;
+            };
+            return raptor_router_->BuildWeights(to_stops(origins), to_stops(targets));
+        }
+        default:
+            return compact_router_ ? compact_router_->BuildWeights(origins, targets) : router_->BuildWeights(origins, targets);
+    }
+}
+
+// Граф нужен движкам целиком, поэтому для ограниченного поиска в режимах на графе
+// всегда держится и DijkstraRouter. Прибытием на остановку считается её первая вершина
+std::vector<std::pair<const Stop*, double>> Router::FindReachableStops(uint32_t stop_id, double max_time) const {
+    const graph::VertexId from = GetStopVertex(stop_id);
+    std::vector<std::pair<const Stop*, double>> stops;
+    if (settings_.routing_mode == RoutingMode::RAPTOR) {
+        WaitWarmUp();
+        for (const auto& [stop, weight] : raptor_router_->BuildReachable(static_cast<uint32_t>(from / 2), max_time)) {
+            stops.emplace_back(stops_[stop], weight);
+        }
+    }
+    else {
+        for (const auto& [vertex, weight] : dijkstra_router_->BuildReachable(from, max_time)) {
+            if (vertex % 2 == 0 && vertex / 2 < stops_.size()) {
+                stops.emplace_back(stops_[vertex / 2], weight);
+            }
+        }
+    }
+    std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second != rhs.second ? lhs.second < rhs.second : lhs.first->name < rhs.first->name;
+    });
+    return stops;
+}
+
+void Router::UpdateBuses(const Catalogue& catalogue) {
+    WaitWarmUp();
+    static constexpr uint32_t NO_BUS = std::numeric_limits<uint32_t>::max();
+    if (settings_.routing_mode == RoutingMode::RAPTOR) {
+        // В графе только рёбра ожидания, достаточно заново собрать маршруты автобусов
+        FillNameIds(catalogue);
+        BuildRouter(catalogue);
+        return;
+    }
+    if (settings_.graph_layout == GraphLayout::ROUTE_PATTERNS) {
+        // Цепочкам новых автобусов нужны новые вершины, поэтому граф строится заново
+        // с прежней нумерацией остановок
+        BuildGraph(catalogue, stops_);
+        return;
+    }
+    const std::vector<const Bus*> old_buses = std::move(buses_);
+    buses_.clear();
+    std::unordered_map<const Bus*, uint32_t> bus_ids;
+    for (const Bus* bus_info : catalogue.GetSortedAllBuses()) {
+        bus_ids[bus_info] = static_cast<uint32_t>(buses_.size());
+        buses_.push_back(bus_info);
+    }
+    // Номера оставшихся автобусов сдвигаются, удалённые получают NO_BUS
+    std::vector<uint32_t> new_bus_ids(old_buses.size(), NO_BUS);
+    for (size_t i = 0; i < old_buses.size(); ++i) {
+        const auto it = bus_ids.find(old_buses[i]);
+        if (it != bus_ids.end()) {
+            new_bus_ids[i] = it->second;
+            bus_ids.erase(it);
+        }
+    }
+
+    std::vector<graph::Edge<double>> added;
+    for (const auto& [bus_info, bus_id] : bus_ids) {
+        for (const Stop* stop : bus_info->stops) {
+            if (stop->id >= stop_vertices_.size()) {
+                throw std::invalid_argument("Bus " + bus_info->number + " uses a stop missing from the routing graph");
+            }
+        }
+        const auto bus_edges = BuildBusEdges(catalogue, bus_id);
+        added.insert(added.end(), bus_edges.begin(), bus_edges.end());
+    }
+
+    std::vector<bool> removed(graph_.GetEdgeCount(), false);
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.quality == 0) {
+            continue;
+        }
+        if (new_bus_ids[edge.name_id] == NO_BUS) {
+            removed[edge_id] = true;
+        }
+        else {
+            graph_.SetEdgeNameId(edge_id, new_bus_ids[edge.name_id]);
+        }
+    }
+    if (settings_.prune_dominated_edges) {
+        RemoveDominatedUpdates(catalogue, bus_ids, removed, added);
+    }
+
+    const graph::EdgesUpdate update = graph_.UpdateEdges(removed, added);
+    switch (settings_.routing_mode) {
+        case RoutingMode::ALL_PAIRS:
+            if (compact_router_) {
+                compact_router_->UpdateRoutes(update);
+            }
+            else {
+                router_->UpdateRoutes(update);
+            }
+            break;
+        case RoutingMode::DIJKSTRA:
+            break;
+        default:
+            // Иерархия зависит от порядка сжатия всех вершин, поэтому строится заново
+            BuildRouter(catalogue);
+            break;
+    }
+}
+
+graph::RoutesRepairStats Router::UpdateEdgeWeights(const std::vector<std::pair<graph::EdgeId, double>>& edge_weights) {
+    WaitWarmUp();
+    if (settings_.routing_mode == RoutingMode::RAPTOR) {
+        throw std::logic_error("Edge weights can't be changed in RAPTOR mode");
+    }
+    const graph::WeightsUpdate update = graph_.UpdateEdgeWeights(edge_weights);
+    switch (settings_.routing_mode) {
+        case RoutingMode::ALL_PAIRS:
+            return compact_router_ ? compact_router_->UpdateWeights(update) : router_->UpdateWeights(update);
+        case RoutingMode::CONTRACTION_HIERARCHY:
+            if (!update.increased_edge_ids.empty() || !update.decreased_edge_ids.empty()) {
+                contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+            }
+            return {};
+        default:
+            return {};
+    }
+}
+
+graph::VertexId Router::GetStopVertex(uint32_t stop_id) const {
+    return stop_vertices_.at(stop_id);
 }
 
 const graph::DirectedWeightedGraph<double>& Router::GetGraph() const {
     return graph_;
 }
 
-void Router::SetGraph(const graph::DirectedWeightedGraph<double> graph, const std::map<std::string, graph::VertexId> stop_ids) {
+std::string_view Router::GetEdgeName(const graph::Edge<double>& edge) const {
+    return edge.quality == 0 ? std::string_view(stops_.at(edge.name_id)->name)
+                             : std::string_view(buses_.at(edge.name_id)->number);
+}
+
+void Router::SetGraph(const Catalogue& catalogue, const graph::DirectedWeightedGraph<double> graph, const std::vector<graph::VertexId> stop_vertices) {
+    WaitWarmUp();
     graph_ = graph;
-    stop_ids_ = stop_ids;
-    router_ = std::make_unique<graph::Router<double>>(graph_);
+    stop_vertices_ = stop_vertices;
+    FillNameIds(catalogue);
+    BuildRouter(catalogue);
+}
+
+void Router::SetGraph(const Catalogue& catalogue, graph::DirectedWeightedGraph<double> graph, std::vector<graph::VertexId> stop_vertices, RouterDataLoader load_router_data) {
+    SetGraphInBackground(catalogue, std::move(graph), std::move(stop_vertices), std::move(load_router_data));
+    WaitWarmUp();
+}
+
+void Router::SetGraphInBackground(const Catalogue& catalogue, graph::DirectedWeightedGraph<double> graph, std::vector<graph::VertexId> stop_vertices, RouterDataLoader load_router_data) {
+    WaitWarmUp();
+    graph_ = std::move(graph);
+    stop_vertices_ = std::move(stop_vertices);
+    FillNameIds(catalogue);
+    router_.reset();
+    compact_router_.reset();
+    dijkstra_router_.reset();
+    contraction_hierarchy_.reset();
+    raptor_router_.reset();
+    if (settings_.routing_mode != RoutingMode::RAPTOR) {
+        dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
+    }
+    // Всё, что читается из справочника, собирается до запуска задачи: фоновый поток
+    // не обращается к catalogue, и тот может быть уничтожен раньше Router
+    std::vector<RoutePattern> patterns = settings_.routing_mode == RoutingMode::RAPTOR
+        ? BuildRoutePatterns(catalogue) : std::vector<RoutePattern>{};
+    warm_up_ = std::async(std::launch::async, [this, patterns = std::move(patterns), load_router_data = std::move(load_router_data)]() mutable {
+        RouterData router_data = load_router_data();
+        // Загрузчик держит разобранную базу, после разбора она не нужна
+        load_router_data = nullptr;
+        AdoptRouterData(std::move(router_data), std::move(patterns));
+    }).share();
 }
 
 const int Router::GetBusWaitTime() const {
-    return bus_wait_time_;
+    return settings_.bus_wait_time;
 }
 
 const double Router::GetBusVelocity() const {
-    return bus_velocity_;
+    return settings_.bus_velocity;
+}
+
+const RoutingSettings& Router::GetRoutingSettings() const {
+    return settings_;
+}
+
+size_t Router::GetPrunedEdgeCount() const {
+    return pruned_edge_count_;
+}
+
+const std::vector<graph::VertexId>& Router::GetStopVertices() const {
+    return stop_vertices_;
+}
+
+bool Router::HasRoutesInternalData() const {
+    WaitWarmUp();
+    return router_ != nullptr;
+}
+
+const graph::Router<double>::RoutesInternalData& Router::GetRoutesInternalData() const {
+    return router_->GetRoutesInternalData();
+}
+
+bool Router::HasCompactRoutesInternalData() const {
+    WaitWarmUp();
+    return compact_router_ != nullptr;
+}
+
+const graph::Router<double, graph::CompactRoutesStorage>::RoutesInternalData& Router::GetCompactRoutesInternalData() const {
+    return compact_router_->GetRoutesInternalData();
+}
+
+bool Router::HasContractionHierarchy() const {
+    WaitWarmUp();
+    return contraction_hierarchy_ != nullptr;
+}
+
+const graph::ContractionHierarchy<double>::HierarchyData& Router::GetHierarchyData() const {
+    return contraction_hierarchy_->GetHierarchyData();
+}
+
+// Остановка с номером i получает вершины 2i и 2i + 1. Выбранный порядок сохраняется
+// в stop_vertices_ и в базе, и update_base его не меняет
+std::vector<const Stop*> Router::OrderStops(const Catalogue& catalogue) const {
+    const StopRange sorted_stops = catalogue.GetSortedAllStops();
+    std::vector<const Stop*> stops(sorted_stops.begin(), sorted_stops.end());
+    switch (settings_.vertex_order) {
+        case VertexOrder::REVERSE_CUTHILL_MCKEE:
+            return OrderByReverseCuthillMcKee(catalogue, stops);
+        case VertexOrder::HILBERT_CURVE:
+            return OrderByHilbertCurve(std::move(stops));
+        default:
+            return stops;
+    }
+}
+
+void Router::FillNameIds(const Catalogue& catalogue) {
+    stops_.assign(stop_vertices_.size(), nullptr);
+    for (uint32_t stop_id = 0; stop_id < stop_vertices_.size(); ++stop_id) {
+        stops_.at(stop_vertices_[stop_id] / 2) = catalogue.GetStop(stop_id);
+    }
+    buses_.clear();
+    for (const Bus* bus : catalogue.GetSortedAllBuses()) {
+        buses_.push_back(bus);
+    }
+}
+
+// В графе без доминируемых рёбер удаление автобуса может оставить пару вершин без ребра,
+// хотя её обслуживает другой автобус: такие рёбра оставшихся автобусов восстанавливаются.
+// Затем для каждой затронутой пары вершин остаётся только самое лёгкое ребро
+void Router::RemoveDominatedUpdates(const Catalogue& catalogue, const std::unordered_map<const Bus*, uint32_t>& added_buses, std::vector<bool>& removed, std::vector<graph::Edge<double>>& added) {
+    const auto pair_key = [](const graph::Edge<double>& edge) {
+        return (static_cast<uint64_t>(edge.from) << 32) | edge.to;
+    };
+    std::unordered_set<uint64_t> uncovered_pairs;
+    std::vector<bool> uncovered_stops(stop_vertices_.size(), false);
+    for (graph::EdgeId edge_id = 0; edge_id < removed.size(); ++edge_id) {
+        if (removed[edge_id]) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            uncovered_pairs.insert(pair_key(edge));
+            uncovered_stops[stops_[edge.from / 2]->id] = true;
+        }
+    }
+    size_t restored_count = 0;
+    for (uint32_t bus_id = 0; bus_id < buses_.size() && !uncovered_pairs.empty(); ++bus_id) {
+        const Bus* bus_info = buses_[bus_id];
+        const bool is_affected = std::any_of(bus_info->stops.begin(), bus_info->stops.end(), [&uncovered_stops](const Stop* stop) {
+            return uncovered_stops[stop->id];
+        });
+        if (added_buses.count(bus_info) || !is_affected) {
+            continue;
+        }
+        for (const auto& edge : BuildBusEdges(catalogue, bus_id)) {
+            if (uncovered_pairs.count(pair_key(edge))) {
+                added.push_back(edge);
+                ++restored_count;
+            }
+        }
+    }
+
+    // Самое лёгкое из добавляемых рёбер каждой пары (из равных - первое)
+    std::unordered_map<uint64_t, size_t> lightest_added;
+    for (size_t i = 0; i < added.size(); ++i) {
+        const auto [it, inserted] = lightest_added.emplace(pair_key(added[i]), i);
+        if (!inserted && added[i].weight < added[it->second].weight) {
+            it->second = i;
+        }
+    }
+    std::vector<bool> is_kept(added.size(), false);
+    size_t dominated_count = 0;
+    for (const auto& [key, index] : lightest_added) {
+        const auto& added_edge = added[index];
+        bool is_dominated = false;
+        for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(added_edge.from)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (removed[edge_id] || edge.to != added_edge.to) {
+                continue;
+            }
+            if (edge.weight <= added_edge.weight) {
+                is_dominated = true;
+            }
+            else {
+                removed[edge_id] = true;
+                ++dominated_count;
+            }
+        }
+        is_kept[index] = !is_dominated;
+    }
+    std::vector<graph::Edge<double>> kept_added;
+    for (size_t i = 0; i < added.size(); ++i) {
+        if (is_kept[i]) {
+            kept_added.push_back(added[i]);
+        }
+    }
+    pruned_edge_count_ = pruned_edge_count_ + dominated_count + (added.size() - kept_added.size()) - restored_count;
+    added = std::move(kept_added);
+}
+
+void Router::BuildRouter(const Catalogue& catalogue) {
+    WaitWarmUp();
+    router_.reset();
+    compact_router_.reset();
+    dijkstra_router_.reset();
+    contraction_hierarchy_.reset();
+    raptor_router_.reset();
+    switch (settings_.routing_mode) {
+        case RoutingMode::ALL_PAIRS:
+            if (settings_.compact_routes_table) {
+                compact_router_ = std::make_unique<graph::Router<double, graph::CompactRoutesStorage>>(graph_);
+            }
+            else {
+                router_ = std::make_unique<graph::Router<double>>(graph_);
+            }
+            break;
+        case RoutingMode::DIJKSTRA:
+            break;
+        case RoutingMode::CONTRACTION_HIERARCHY:
+            contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+            break;
+        case RoutingMode::RAPTOR:
+            raptor_router_ = std::make_unique<RaptorRouter>(stops_.size(), BuildRoutePatterns(catalogue),
+                static_cast<double>(settings_.bus_wait_time), settings_.bus_velocity);
+            return;
+    }
+    dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
 }
 
-const Router Router::GetRouterSettings() const {
-    return { bus_wait_time_, bus_velocity_ };
+// Только движок режима, DijkstraRouter создаётся отдельно. Таблица и иерархия берутся
+// из базы, у DijkstraRouter и RAPTOR предрасчёта в базе нет, RAPTOR собирается из patterns
+void Router::AdoptRouterData(RouterData router_data, std::vector<RoutePattern> patterns) {
+    switch (settings_.routing_mode) {
+        case RoutingMode::ALL_PAIRS:
+            if (settings_.compact_routes_table) {
+                compact_router_ = std::make_unique<graph::Router<double, graph::CompactRoutesStorage>>(graph_,
+                    std::move(router_data.compact_routes_internal_data));
+            }
+            else {
+                router_ = std::make_unique<graph::Router<double>>(graph_, std::move(router_data.routes_internal_data));
+            }
+            break;
+        case RoutingMode::DIJKSTRA:
+            break;
+        case RoutingMode::CONTRACTION_HIERARCHY:
+            contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_, std::move(router_data.hierarchy_data));
+            break;
+        case RoutingMode::RAPTOR:
+            raptor_router_ = std::make_unique<RaptorRouter>(stops_.size(), std::move(patterns),
+                static_cast<double>(settings_.bus_wait_time), settings_.bus_velocity);
+            break;
+    }
 }
 
-const std::map<std::string, graph::VertexId> Router::GetStopIds() const {
-    return stop_ids_;
+// В режиме RAPTOR рёбер поездок в графе нет, и искать без движка нечем
+bool Router::ShouldFallBackToDijkstra() const {
+    return warm_up_.valid() && settings_.routing_mode != RoutingMode::RAPTOR
+        && warm_up_.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+// Ошибка фоновой сборки пробрасывается при каждом ожидании
+void Router::WaitWarmUp() const {
+    if (warm_up_.valid()) {
+        warm_up_.get();
+    }
+}
+
+// Кольцевой маршрут проходится в одном направлении, остальные - в обоих,
+// в обратном направлении со своими расстояниями между остановками
+std::vector<RoutePattern> Router::BuildRoutePatterns(const Catalogue& catalogue) const {
+    std::vector<RoutePattern> patterns;
+    patterns.reserve(buses_.size() * 2);
+    for (uint32_t bus_id = 0; bus_id < buses_.size(); ++bus_id) {
+        const auto& stops = buses_[bus_id]->stops;
+        const size_t stops_count = stops.size();
+        RoutePattern forward{ bus_id, std::vector<uint32_t>(stops_count), std::vector<int64_t>(stops_count, 0) };
+        for (size_t k = 0; k < stops_count; ++k) {
+            forward.stops[k] = stop_vertices_[stops[k]->id] / 2;
+            if (k > 0) {
+                forward.distances[k] = forward.distances[k - 1] + catalogue.GetDistance(stops[k - 1], stops[k]);
+            }
+        }
+        if (!buses_[bus_id]->is_circle) {
+            RoutePattern backward{ bus_id, std::vector<uint32_t>(forward.stops.rbegin(), forward.stops.rend()), std::vector<int64_t>(stops_count, 0) };
+            for (size_t k = 1; k < stops_count; ++k) {
+                backward.distances[k] = backward.distances[k - 1]
+                    + catalogue.GetDistance(stops[stops_count - k], stops[stops_count - k - 1]);
+            }
+            patterns.push_back(std::move(forward));
+            patterns.push_back(std::move(backward));
+        }
+        else {
+            patterns.push_back(std::move(forward));
+        }
+    }
+    return patterns;
+}
+
+std::optional<RouteInfo> Router::FindAllPairsRoute(graph::VertexId from, graph::VertexId to) const {
+    return compact_router_ ? MakeRouteInfo(compact_router_->BuildRoute(from, to)) : MakeRouteInfo(router_->BuildRoute(from, to));
+}
+
+// Рёбра между вершинами остановок переносятся как есть. Посадка, поездки по цепочке
+// ROUTE_PATTERNS и высадка собираются в одно ребро автобуса с числом перегонов в quality
+std::optional<RouteInfo> Router::MakeRouteInfo(const std::optional<graph::RouteInfo<double>>& route) const {
+    if (!route) {
+        return std::nullopt;
+    }
+    const graph::VertexId stop_vertex_count = static_cast<graph::VertexId>(stops_.size() * 2);
+    RouteInfo route_info{ route->weight, {} };
+    route_info.edges.reserve(route->edges.size());
+    graph::Edge<double> ride{};
+    for (const graph::EdgeId edge_id : route->edges) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.from < stop_vertex_count && edge.to < stop_vertex_count) {
+            route_info.edges.push_back(edge);
+        }
+        else if (edge.from < stop_vertex_count) {
+            ride = { edge.name_id, 0, edge.from, edge.to, edge.weight };
+        }
+        else if (edge.to >= stop_vertex_count) {
+            ride.quality += edge.quality;
+            ride.weight += edge.weight;
+        }
+        else if (ride.quality > 0) {
+            ride.to = edge.to;
+            ride.weight += edge.weight;
+            route_info.edges.push_back(ride);
+        }
+    }
+    return route_info;
+}
+
+// Каждая поездка раскладывается на ожидание на остановке посадки и саму поездку,
+// как в графе остальных движков
+std::optional<RouteInfo> Router::MakeRouteInfo(const std::optional<RaptorRouter::Journey>& journey, double bus_wait_time) const {
+    if (!journey) {
+        return std::nullopt;
+    }
+    RouteInfo route_info{ journey->weight, {} };
+    route_info.edges.reserve(journey->legs.size() * 2);
+    for (const auto& leg : journey->legs) {
+        route_info.edges.push_back({ leg.board_stop,
+                                     0,
+                                     leg.board_stop * 2,
+                                     leg.board_stop * 2 + 1,
+                                     bus_wait_time });
+        route_info.edges.push_back({ leg.bus_id,
+                                     leg.span_count,
+                                     leg.board_stop * 2 + 1,
+                                     leg.alight_stop * 2,
+                                     leg.ride_time });
+    }
+    return route_info;
 }
 
 } // namespace transport
\ No newline at end of file
@@ -1,50 +1,181 @@
 #pragma once
 
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "raptor_router.h"
 #include "transport_catalogue.h"
+#include "thread_pool.h"
 
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace transport {
 
+enum class RoutingMode {
+    ALL_PAIRS,
+    DIJKSTRA,
+    CONTRACTION_HIERARCHY,
+    // Поиск по маршрутам автобусов без рёбер поездок в графе
+    RAPTOR
+};
+
+// Порядок, в котором остановки получают номера вершин графа
+enum class VertexOrder {
+    // По алфавиту названий
+    NAME,
+    // Обратный Катхилл-Макки по соседству остановок на маршрутах
+    REVERSE_CUTHILL_MCKEE,
+    // По кривой Гильберта на координатах остановок
+    HILBERT_CURVE
+};
+
+// Как поездки на автобусах представлены в графе
+enum class GraphLayout {
+    // Ребро на каждую пару остановок каждого автобуса
+    STOP_PAIRS,
+    // Цепочка вершин вдоль каждого направления автобуса: ребро посадки из остановки,
+    // рёбра поездок между соседними остановками и ребро высадки на остановку
+    ROUTE_PATTERNS
+};
+
+struct RoutingSettings {
+    int bus_wait_time = 0;
+    double bus_velocity = 0.0;
+    RoutingMode routing_mode = RoutingMode::ALL_PAIRS;
+    bool prune_dominated_edges = false;
+    // Число маршрутов в кэше ответов RequestHandler, 0 - кэш отключён
+    size_t route_cache_size = 0;
+    // Таблица ALL_PAIRS во float и 32-битных id рёбер (graph::CompactRoutesStorage)
+    bool compact_routes_table = false;
+    VertexOrder vertex_order = VertexOrder::NAME;
+    GraphLayout graph_layout = GraphLayout::STOP_PAIRS;
+};
+
+// Параметры движения для отдельного запроса вместо заданных в RoutingSettings
+struct RoutingOverrides {
+    std::optional<int> bus_wait_time;
+    std::optional<double> bus_velocity;
+};
+
+// Маршрут с рёбрами по значению: в режиме RAPTOR рёбер поездок в графе нет,
+// и они составляются только для найденного маршрута
+struct RouteInfo {
+    double weight;
+    std::vector<graph::Edge<double>> edges;
+};
+
+// Результаты предварительного расчёта движков маршрутизации, которые хранятся в базе
+struct RouterData {
+    graph::Router<double>::RoutesInternalData routes_internal_data;
+    graph::Router<double, graph::CompactRoutesStorage>::RoutesInternalData compact_routes_internal_data;
+    graph::ContractionHierarchy<double>::HierarchyData hierarchy_data;
+};
+
+// Разбирает RouterData из базы по требованию: таблица маршрутов занимает V^2 ячеек,
+// и её разбор выполняется там же, где собирается движок
+using RouterDataLoader = std::function<RouterData()>;
+
 class Router {
 public:
     //Router() = default;
 
-    Router(const int bus_wait_time, const double bus_velocity)
-        : bus_wait_time_(bus_wait_time)
-        , bus_velocity_(bus_velocity) {}
+    Router(const RoutingSettings& settings)
+        : settings_(settings) {}
 
-    Router(const Router& settings, const Catalogue& catalogue) {
-        bus_wait_time_ = settings.bus_wait_time_;
-        bus_velocity_ = settings.bus_velocity_;
+    Router(const RoutingSettings& settings, const Catalogue& catalogue)
+        : settings_(settings) {
         BuildGraph(catalogue);
     }
     
-    Router(const Router& settings, graph::DirectedWeightedGraph<double> graph, std::map<std::string, graph::VertexId> stop_ids)
-        : bus_wait_time_(settings.bus_wait_time_)
-        , bus_velocity_(settings.bus_velocity_)
+    Router(const RoutingSettings& settings, const Catalogue& catalogue, graph::DirectedWeightedGraph<double> graph, std::vector<graph::VertexId> stop_vertices)
+        : settings_(settings)
         , graph_(graph)
-        , stop_ids_(stop_ids) {
-           router_ = std::make_unique<graph::Router<double>>(graph_);
+        , stop_vertices_(stop_vertices) {
+           FillNameIds(catalogue);
+           BuildRouter(catalogue);
        }
     
     const graph::DirectedWeightedGraph<double>& BuildGraph(const Catalogue& catalogue);
-    const std::optional<graph::Router<double>::RouteInfo> FindRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    const std::optional<RouteInfo> FindRoute(graph::VertexId from, graph::VertexId to) const;
+    // Маршрут при других времени ожидания и скорости без перестроения графа и предрасчёта
+    const std::optional<RouteInfo> FindRoute(graph::VertexId from, graph::VertexId to, const RoutingOverrides& overrides) const;
+    // Маршруты из одной вершины в несколько: поисковые движки обходят граф один раз на всю пачку
+    std::vector<std::optional<RouteInfo>> FindRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets) const;
+    // Времена поездок из каждой origins в каждую targets построчно, бесконечность - маршрута нет
+    std::vector<double> FindTravelTimes(const std::vector<graph::VertexId>& origins, const std::vector<graph::VertexId>& targets) const;
+    // Остановки, до которых можно доехать из stop_from не дольше чем за max_time, по возрастанию времени
+    std::vector<std::pair<const Stop*, double>> FindReachableStops(uint32_t stop_id, double max_time) const;
+    // Приводит граф к текущему набору автобусов справочника: рёбра удалённых автобусов
+    // убираются, рёбра новых добавляются, остальные не пересчитываются.
+    // Новые автобусы должны проходить только через уже известные остановки
+    void UpdateBuses(const Catalogue& catalogue);
+    // Задаёт новые веса рёбрам графа (например, с учётом задержек на перегонах).
+    // Таблица ALL_PAIRS восстанавливается частично, и возвращается стоимость восстановления;
+    // иерархия строится заново, DijkstraRouter предрасчёта не имеет. В режиме RAPTOR
+    // поездки не представлены рёбрами, и веса менять нельзя.
+    // Рёбра, удалённые prune_dominated_edges, не возвращаются, даже если стали бы лучше оставшихся
+    graph::RoutesRepairStats UpdateEdgeWeights(const std::vector<std::pair<graph::EdgeId, double>>& edge_weights);
+    // Первая вершина остановки по её id в справочнике
+    graph::VertexId GetStopVertex(uint32_t stop_id) const;
     const graph::DirectedWeightedGraph<double>& GetGraph() const;
-    void SetGraph(const graph::DirectedWeightedGraph<double> graph, const std::map<std::string, graph::VertexId> stop_ids);
+    std::string_view GetEdgeName(const graph::Edge<double>& edge) const;
+    void SetGraph(const Catalogue& catalogue, const graph::DirectedWeightedGraph<double> graph, const std::vector<graph::VertexId> stop_vertices);
+    void SetGraph(const Catalogue& catalogue, graph::DirectedWeightedGraph<double> graph, std::vector<graph::VertexId> stop_vertices, RouterDataLoader load_router_data);
+    // Как SetGraph, но разбор router_data и сборка движка идут в фоновом потоке, и вызов сразу возвращается.
+    // Пока движок не готов, маршруты в режимах на графе ищет DijkstraRouter, запросы RAPTOR
+    // и изменения графа ждут готовности. Фоновая сборка catalogue не читает,
+    // а сам Router после вызова нельзя перемещать: движок ссылается на его граф
+    void SetGraphInBackground(const Catalogue& catalogue, graph::DirectedWeightedGraph<double> graph, std::vector<graph::VertexId> stop_vertices, RouterDataLoader load_router_data);
     const int GetBusWaitTime() const;
     const double GetBusVelocity() const;
-    const Router GetRouterSettings() const;
-    const std::map<std::string, graph::VertexId> GetStopIds() const;
+    const RoutingSettings& GetRoutingSettings() const;
+    size_t GetPrunedEdgeCount() const;
+    const std::vector<graph::VertexId>& GetStopVertices() const;
+    bool HasRoutesInternalData() const;
+    const graph::Router<double>::RoutesInternalData& GetRoutesInternalData() const;
+    bool HasCompactRoutesInternalData() const;
+    const graph::Router<double, graph::CompactRoutesStorage>::RoutesInternalData& GetCompactRoutesInternalData() const;
+    bool HasContractionHierarchy() const;
+    const graph::ContractionHierarchy<double>::HierarchyData& GetHierarchyData() const;
 
 private:
-    int bus_wait_time_ = 0;
-    double bus_velocity_ = 0.0;
+    RoutingSettings settings_;
+    size_t pruned_edge_count_ = 0;
 
     graph::DirectedWeightedGraph<double> graph_;
-    std::map<std::string, graph::VertexId> stop_ids_;
+    // Первая вершина каждой остановки по её id в справочнике
+    std::vector<graph::VertexId> stop_vertices_;
+    // Остановки (по номеру пары вершин) и автобусы в порядке name_id рёбер графа
+    std::vector<const Stop*> stops_;
+    std::vector<const Bus*> buses_;
     std::unique_ptr<graph::Router<double>> router_;
+    std::unique_ptr<graph::Router<double, graph::CompactRoutesStorage>> compact_router_;
+    std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_;
+    std::unique_ptr<graph::ContractionHierarchy<double>> contraction_hierarchy_;
+    std::unique_ptr<RaptorRouter> raptor_router_;
+    // Фоновая сборка движка из SetGraphInBackground. Объявлена последней, чтобы при разрушении
+    // Router сначала дождаться её, а потом освобождать граф
+    std::shared_future<void> warm_up_;
+
+    std::vector<graph::Edge<double>> BuildBusEdges(const Catalogue& catalogue, uint32_t bus_id) const;
+    const graph::DirectedWeightedGraph<double>& BuildGraph(const Catalogue& catalogue, std::vector<const Stop*> ordered_stops);
+    std::vector<const Stop*> OrderStops(const Catalogue& catalogue) const;
+    void FillNameIds(const Catalogue& catalogue);
+    void RemoveDominatedUpdates(const Catalogue& catalogue, const std::unordered_map<const Bus*, uint32_t>& added_buses, std::vector<bool>& removed, std::vector<graph::Edge<double>>& added);
+    void BuildRouter(const Catalogue& catalogue);
+    void AdoptRouterData(RouterData router_data, std::vector<RoutePattern> patterns);
+    bool ShouldFallBackToDijkstra() const;
+    void WaitWarmUp() const;
+    std::vector<RoutePattern> BuildRoutePatterns(const Catalogue& catalogue) const;
+    std::optional<RouteInfo> MakeRouteInfo(const std::optional<graph::RouteInfo<double>>& route) const;
+    std::optional<RouteInfo> FindAllPairsRoute(graph::VertexId from, graph::VertexId to) const;
+    std::optional<RouteInfo> MakeRouteInfo(const std::optional<RaptorRouter::Journey>& journey, double bus_wait_time) const;
 };
 
 } // namespace transport
\ No newline at end of file